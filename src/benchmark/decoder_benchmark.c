@@ -0,0 +1,241 @@
+/**
+ * @file
+ * Throughput benchmark of the refill pipeline, separate firmware showing CPU headroom left at each sample rate.
+ *
+ * For every format and sample rate the load is the output interrupt at the output rate, with the write of the selected
+ * audio output backend measured, plus reading, decoding
+ * and resampling of sectors at the song data rate. Headroom is the CPU time left for the user interface.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <avr/io.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../hal/ports.h"
+#include "../view/screen_utils.h"
+#include "../lib/fat-fs/diskio.h"
+#include "../player/playback_buffer.h"
+#include "../player/sample_decoder.h"
+#include "../player/resampler.h"
+#include "../player/wav_player.h"
+#include "../player/wav_file.h"
+#include "../player/audio_output.h"
+
+/**
+ * @brief Number of measured runs, results are averaged.
+ */
+#define RUNS 8
+
+/**
+ * @brief Timer prescaler used for measurements, long enough for a bit-banged sector read.
+ */
+#define TIMER_PRESCALER 8
+
+/**
+ * @brief Cycles of the output interrupt without the backend write: prologue and epilogue, buffer pointer check.
+ * Estimated from its generated code, the end of a half adds a call once per sector.
+ */
+#define OUTPUT_INTERRUPT_CYCLES 40
+
+/**
+ * @brief Format measured by the benchmark.
+ */
+struct BenchmarkedFormat {
+    const char *name; ///< Row label.
+    uint16_t formatTag; ///< Format tag.
+    uint16_t bitsPerSample; ///< Bits per sample.
+    uint16_t numberOfChannels; ///< Number of channels.
+    uint16_t blockAlign; ///< Block align.
+};
+
+/**
+ * @brief Measured formats, one row each.
+ */
+static const struct BenchmarkedFormat formats[] = {
+        {"P8 ", WAV_FORMAT_PCM,       8,  1, 1},
+        {"P16", WAV_FORMAT_PCM,       16, 1, 2},
+        {"S8 ", WAV_FORMAT_PCM,       8,  2, 2},
+        {"S16", WAV_FORMAT_PCM,       16, 2, 4},
+        {"U8 ", WAV_FORMAT_MULAW,     8,  1, 1},
+        {"A4 ", WAV_FORMAT_IMA_ADPCM, 4,  1, 256},
+};
+
+/**
+ * @brief Sample rates, one column each.
+ */
+static const uint16_t sampleRates[] = {8000, 11025, 16000, 22050, 44100};
+
+/**
+ * @brief Work area, big enough for a sector of raw data expanded twice.
+ */
+static uint8_t work[2 * FF_MAX_SS];
+
+/**
+ * @brief Start cycle counting timer.
+ */
+static void timerStart() {
+    TCNT1 = 0;
+    TCCR1B = 1 << CS11; // NOLINT
+}
+
+/**
+ * @brief Stop cycle counting timer.
+ * @return Number of cycles since @ref timerStart.
+ */
+static uint32_t timerStop() {
+    TCCR1B = 0;
+    return (uint32_t) TCNT1 * TIMER_PRESCALER;
+}
+
+/**
+ * @brief Measure reading of consecutive sectors from the card, as the refill task does.
+ * @return Average number of cycles per sector, 0 if the card could not be read.
+ */
+static uint32_t measureRead() {
+    if (disk_initialize(0) & STA_NOINIT) { // NOLINT
+        return 0;
+    }
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < RUNS; i++) {
+        timerStart();
+        DRESULT result = disk_read(0, work, i, 1);
+        total += timerStop();
+        if (result != RES_OK) {
+            return 0;
+        }
+    }
+    return total / RUNS;
+}
+
+/**
+ * @brief Measure writing a sample to the audio output backend.
+ * @return Average number of cycles per sample, including loop overhead.
+ */
+static uint32_t measureOutput() {
+    timerStart();
+    for (uint16_t i = 0; i < PLAYBACK_BUFFER_HALF_SIZE; i++) {
+        audioOutputWrite((uint8_t) i);
+    }
+    uint32_t result = timerStop() / PLAYBACK_BUFFER_HALF_SIZE;
+    audioOutputWrite(AUDIO_OUTPUT_SILENCE);
+    return result;
+}
+
+/**
+ * @brief Measure decoding of a sector, in the same layout as the refill task uses.
+ * @param[out] decoder : Measured decoder.
+ * @return Average number of cycles per sector.
+ */
+static uint32_t measureDecode(struct SampleDecoder *decoder) {
+    // Sector is decoded at once, from the end of work area to its beginning, like a half is refilled.
+    uint8_t *raw = work + sizeof(work) - FF_MAX_SS;
+    uint8_t *output = work;
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < RUNS; i++) {
+        for (uint16_t j = 0; j < FF_MAX_SS; j++) {
+            raw[j] = (uint8_t) rand();
+        }
+        sampleDecoderReset(decoder);
+        timerStart();
+        decoder->decode(decoder, output, raw, FF_MAX_SS);
+        total += timerStop();
+    }
+    return total / RUNS;
+}
+
+/**
+ * @brief Measure resampling of a decoded sector down to the output rate.
+ * @param[in] sampleRate : Sample rate of decoded samples.
+ * @param[in] samples : Number of decoded samples in a sector.
+ * @return Average number of cycles per sector, 0 if samples are played at their own rate.
+ */
+static uint32_t measureResample(uint32_t sampleRate, uint16_t samples) {
+    if (sampleRate <= WAV_PLAYER_OUTPUT_RATE) {
+        return 0;
+    }
+    struct Resampler resampler;
+    resamplerInit(&resampler, sampleRate, WAV_PLAYER_OUTPUT_RATE);
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < RUNS; i++) {
+        timerStart();
+        resamplerProcess(&resampler, work, samples);
+        total += timerStop();
+    }
+    return total / RUNS;
+}
+
+/**
+ * @brief Print number right aligned in a column of @p width characters.
+ * @param[in] number : Printed number.
+ * @param[in] width : Column width.
+ */
+static void printColumn(int32_t number, uint8_t width) {
+    char buffer[12] = {0};
+    ltoa(number, buffer, 10);
+    for (uint8_t length = (uint8_t) strlen(buffer); length < width; length++) {
+        lcdWrite(' ');
+    }
+    lcdPrint(buffer);
+}
+
+/**
+ * @brief Measure formats, print table of CPU time left in percents, "--" if the format can not keep up.
+ */
+int main() {
+    portsInit();
+
+    audioOutputInit();
+    lcdInit();
+    clearScreen();
+
+    uint32_t output = OUTPUT_INTERRUPT_CYCLES + measureOutput();
+    lcdPrint(AUDIO_OUTPUT_NAME);
+    printColumn((int32_t) output, 4);
+    lcdPrint(" cyc\n");
+
+    uint32_t read = measureRead();
+    lcdPrint("Read cycles:");
+    printColumn((int32_t) read, 7);
+    lcdWrite('\n');
+    if (read == 0) {
+        lcdPrint("No card!\n");
+    }
+
+    lcdPrint("kHz");
+    for (uint8_t i = 0; i < sizeof(sampleRates) / sizeof(sampleRates[0]); i++) {
+        printColumn(sampleRates[i] / 1000, 3);
+    }
+    lcdWrite('\n');
+
+    for (uint8_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        const struct BenchmarkedFormat *format = &formats[i];
+        struct SampleDecoder decoder;
+        sampleDecoderInit(&decoder, format->formatTag, format->bitsPerSample, format->numberOfChannels,
+                          format->blockAlign);
+        uint32_t sectorCost = read + measureDecode(&decoder);
+        uint16_t samples = (uint16_t) (((uint32_t) FF_MAX_SS << 8) / decoder.bytesPerSample); // NOLINT
+
+        lcdPrint(format->name);
+        for (uint8_t j = 0; j < sizeof(sampleRates) / sizeof(sampleRates[0]); j++) {
+            uint32_t sampleRate = sampleRates[j];
+            uint32_t outputRate = sampleRate < WAV_PLAYER_OUTPUT_RATE ? sampleRate : WAV_PLAYER_OUTPUT_RATE;
+            // Sectors per second, times 16 to keep precision without overflow.
+            uint32_t sectorsPerSecond = sampleRate * decoder.bytesPerSample / (256UL * FF_MAX_SS / 16);
+            uint32_t sectorCycles = sectorCost + measureResample(sampleRate, samples);
+            uint32_t load = sectorCycles * sectorsPerSecond / 16 + outputRate * output;
+            int32_t headroom = 100 - (int32_t) (load / (F_CPU / 100));
+            if (headroom > 0) {
+                printColumn(headroom < 100 ? headroom : 99, 3);
+            }
+            else {
+                lcdPrint(" --");
+            }
+        }
+        lcdWrite('\n');
+    }
+
+    for (;;) {
+    }
+}
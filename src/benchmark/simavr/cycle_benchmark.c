@@ -0,0 +1,418 @@
+/**
+ * @file
+ * Cycle benchmark: runs the player firmware under simavr with a simulated SD card, plays directory entries
+ * and measures the output interrupt and the refill, per song.
+ *
+ * For each entry of the card root directory, counted from 1 as the list shows it, the firmware is started anew,
+ * the entry is selected by buttons and played for a number of simulated seconds. Reported are cycles per output
+ * interrupt body (__vector_7, TIMER1_COMPA_vect), worst interrupt latency from compare match to its body,
+ * cycles per sourceRefillBuffer() call without interrupts taken inside it, and the maximum output rate
+ * the CPU sustains with the measured cost per sample, at 1, 8 and 16MHz (fuse targets).
+ *
+ * Usage: cycle-benchmark [--hardware-spi] [--seconds N] <firmware.elf> <card.img> <entry>...
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_elf.h>
+#include <simavr/avr_ioport.h>
+#include <simavr/avr_spi.h>
+#include "sd_card.h"
+#include "elf_symbols.h"
+#include "probe.h"
+
+/**
+ * @brief Simulated microcontroller.
+ */
+#define MCU "atmega32"
+
+/**
+ * @brief Symbol of the output interrupt body, TIMER1_COMPA_vect of ATmega32.
+ */
+#define INTERRUPT_SYMBOL "__vector_7"
+
+/**
+ * @brief Symbol of the refill.
+ */
+#define REFILL_SYMBOL "sourceRefillBuffer"
+
+/**
+ * @brief Data space address of TIFR on ATmega32.
+ */
+#define TIFR_ADDRESS 0x58
+
+/**
+ * @brief OCF1A bit of TIFR, set by compare match until the interrupt is taken.
+ */
+#define OCF1A_MASK (1 << 4)
+
+/**
+ * @brief Cycles of taking an interrupt before its body: response and jump from the vector table.
+ */
+#define INTERRUPT_ENTRY_CYCLES 7
+
+/**
+ * @brief Time given to the firmware to mount the card and list the root directory.
+ */
+#define BOOT_MILLISECONDS 1500
+
+/**
+ * @brief Button press duration, shorter than debouncing of the controller, so every press acts once.
+ */
+#define PRESS_MILLISECONDS 30
+
+/**
+ * @brief Time between button presses, long enough for the list to be redrawn.
+ */
+#define PRESS_PERIOD_MILLISECONDS 400
+
+/**
+ * @brief Time given to the firmware to start playing after selecting an entry.
+ */
+#define START_TIMEOUT_MILLISECONDS 2000
+
+/**
+ * @brief Default number of measured seconds per entry.
+ */
+#define DEFAULT_SECONDS 2
+
+/**
+ * @brief Left button, moving the selection down the list, on PA6.
+ */
+#define LEFT_BUTTON_PIN 6
+
+/**
+ * @brief Middle button, starting to play, on PA5.
+ */
+#define MIDDLE_BUTTON_PIN 5
+
+/**
+ * @brief Right button on PA4.
+ */
+#define RIGHT_BUTTON_PIN 4
+
+/**
+ * @brief Bit-banged card pins on port A: DO, DI, SCLK and CS, as in sdmm.c.
+ */
+enum CardPin {
+    CARD_PIN_DO = 0,
+    CARD_PIN_DI = 1,
+    CARD_PIN_CLOCK = 2,
+    CARD_PIN_SELECT = 3,
+};
+
+/**
+ * @brief Hardware SPI card select, PB4 as in sdmm.c.
+ */
+#define CARD_HARDWARE_SELECT_PIN 4
+
+/**
+ * @brief Results of a single entry.
+ */
+struct Measurement {
+    struct Probe interrupt; ///< Output interrupt body.
+    struct Probe refill; ///< Refill calls.
+    avr_cycle_count_t worstLatency; ///< Longest time from compare match to the interrupt body.
+    bool started; ///< Flag indicating if the output interrupt ran at all.
+};
+
+/**
+ * @brief Card bus state. Port writes notify every pin, changed or not, so levels are kept to find edges.
+ */
+struct CardBus {
+    avr_irq_t *dataOut; ///< DO pin driven by the card, or SPI input with hardware SPI.
+    uint8_t dataIn; ///< Level of DI pin.
+    uint8_t clock; ///< Level of SCLK pin.
+    uint8_t select; ///< Level of CS pin.
+    uint8_t shift; ///< Bits received in the current byte.
+    uint8_t bits; ///< Number of bits in @ref shift.
+};
+
+/**
+ * @brief Card bus, there is a single card.
+ */
+static struct CardBus bus;
+
+/**
+ * @brief Present next bit of the card output on DO.
+ */
+static void bitBangPresent() {
+    avr_raise_irq(bus.dataOut, (uint32_t) (sdCardOutput() >> (7 - bus.bits) & 1)); // NOLINT
+}
+
+/**
+ * @brief DI pin changed.
+ */
+static void bitBangDataIn(struct avr_irq_t *irq, uint32_t value, void *param) {
+    (void) irq;
+    (void) param;
+    bus.dataIn = (uint8_t) (value & 1);
+}
+
+/**
+ * @brief SCLK pin changed: a bit is exchanged at the rising edge, the next one is presented after it.
+ */
+static void bitBangClock(struct avr_irq_t *irq, uint32_t value, void *param) {
+    (void) irq;
+    (void) param;
+    uint8_t rising = value && !bus.clock;
+    bus.clock = (uint8_t) (value & 1);
+    if (!rising) {
+        return;
+    }
+    bus.shift = (uint8_t) (bus.shift << 1 | bus.dataIn); // NOLINT
+    if (++bus.bits == 8) {
+        bus.bits = 0;
+        sdCardExchange(bus.shift);
+    }
+    bitBangPresent();
+}
+
+/**
+ * @brief Bit-banged CS pin changed, active low, a byte starts with it.
+ */
+static void bitBangSelect(struct avr_irq_t *irq, uint32_t value, void *param) {
+    (void) irq;
+    (void) param;
+    if ((value & 1) == bus.select) {
+        return;
+    }
+    bus.select = (uint8_t) (value & 1);
+    sdCardSelect(!bus.select);
+    bus.bits = 0;
+    bitBangPresent();
+}
+
+/**
+ * @brief Hardware SPI CS pin changed, active low.
+ */
+static void spiSelect(struct avr_irq_t *irq, uint32_t value, void *param) {
+    (void) irq;
+    (void) param;
+    sdCardSelect(!value);
+}
+
+/**
+ * @brief Hardware SPI sent a byte, the card answers at once.
+ */
+static void spiOutput(struct avr_irq_t *irq, uint32_t value, void *param) {
+    (void) irq;
+    (void) param;
+    avr_raise_irq(bus.dataOut, sdCardExchange((uint8_t) value));
+}
+
+/**
+ * @brief Connect the card to the simulated microcontroller.
+ * @param[out] avr : Simulated microcontroller.
+ * @param[in] hardwareSpi : @p true if the firmware is built with SD_HARDWARE_SPI.
+ */
+static void connectCard(avr_t *avr, bool hardwareSpi) {
+    bus = (struct CardBus) {.select = 1};
+    if (hardwareSpi) {
+        bus.dataOut = avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_INPUT);
+        avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_OUTPUT), spiOutput, NULL);
+        avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), CARD_HARDWARE_SELECT_PIN),
+                                spiSelect, NULL);
+        return;
+    }
+    bus.dataOut = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('A'), CARD_PIN_DO);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('A'), CARD_PIN_DI), bitBangDataIn, NULL);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('A'), CARD_PIN_CLOCK), bitBangClock, NULL);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('A'), CARD_PIN_SELECT), bitBangSelect,
+                            NULL);
+    bitBangPresent();
+}
+
+/**
+ * @brief Set button level, buttons short pins to ground when pressed.
+ * @param[out] avr : Simulated microcontroller.
+ * @param[in] pin : Button pin on port A.
+ * @param[in] pressed : @p true to press, @p false to release.
+ */
+static void setButton(avr_t *avr, uint8_t pin, bool pressed) {
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('A'), pin), !pressed);
+}
+
+/**
+ * @brief Convert milliseconds to cycles.
+ */
+static avr_cycle_count_t millisecondsToCycles(uint32_t milliseconds) {
+    return (avr_cycle_count_t) F_CPU / 1000 * milliseconds;
+}
+
+/**
+ * @brief Play an entry and measure it.
+ * @param[in] firmware : Loaded firmware.
+ * @param[in] entry : Entry of the root directory, counted from 1.
+ * @param[in] hardwareSpi : @p true if the firmware is built with SD_HARDWARE_SPI.
+ * @param[in] seconds : Measured time.
+ * @param[out] measurement : Measured values, with probe addresses set.
+ * @return @p true on success, @p false if the simulation failed.
+ */
+static bool measureEntry(elf_firmware_t *firmware, uint16_t entry, bool hardwareSpi, uint32_t seconds,
+                         struct Measurement *measurement) {
+    avr_t *avr = avr_make_mcu_by_name(MCU);
+    if (avr == NULL) {
+        return false;
+    }
+    avr_init(avr);
+    avr_load_firmware(avr, firmware);
+    avr->frequency = F_CPU;
+    connectCard(avr, hardwareSpi);
+    setButton(avr, LEFT_BUTTON_PIN, false);
+    setButton(avr, MIDDLE_BUTTON_PIN, false);
+    setButton(avr, RIGHT_BUTTON_PIN, false);
+
+    // Left button is pressed entry - 1 times, then the middle one.
+    avr_cycle_count_t presses = millisecondsToCycles(BOOT_MILLISECONDS);
+    avr_cycle_count_t startDeadline = presses + millisecondsToCycles(PRESS_PERIOD_MILLISECONDS) * entry
+                                      + millisecondsToCycles(START_TIMEOUT_MILLISECONDS);
+    avr_cycle_count_t end = 0;
+    avr_cycle_count_t compareMatch = 0;
+    uint16_t pressed = 0;
+    bool held = false;
+
+    bool result = true;
+    for (;;) {
+        int state = avr_run(avr);
+        if (state == cpu_Done || state == cpu_Crashed) {
+            result = false;
+            break;
+        }
+        avr_cycle_count_t cycle = avr->cycle;
+
+        avr_cycle_count_t pressStart = presses + millisecondsToCycles(PRESS_PERIOD_MILLISECONDS) * pressed;
+        if (pressed < entry && cycle >= pressStart) {
+            uint8_t button = pressed + 1 == entry ? MIDDLE_BUTTON_PIN : LEFT_BUTTON_PIN;
+            if (!held) {
+                setButton(avr, button, true);
+                held = true;
+            }
+            else if (cycle >= pressStart + millisecondsToCycles(PRESS_MILLISECONDS)) {
+                setButton(avr, button, false);
+                held = false;
+                pressed++;
+            }
+        }
+
+        uint16_t stack = (uint16_t) (avr->data[R_SPL] | avr->data[R_SPH] << 8); // NOLINT
+        if (!measurement->interrupt.active && (avr->data[TIFR_ADDRESS] & OCF1A_MASK) && compareMatch == 0) {
+            compareMatch = cycle;
+        }
+        if (!measurement->interrupt.active && avr->pc == measurement->interrupt.address) {
+            // Flag of the first one is set before its interrupt is enabled, so its latency does not count.
+            if (measurement->started && compareMatch != 0 && cycle - compareMatch > measurement->worstLatency) {
+                measurement->worstLatency = cycle - compareMatch;
+            }
+            if (!measurement->started) {
+                measurement->started = true;
+                end = cycle + (avr_cycle_count_t) F_CPU * seconds;
+            }
+            compareMatch = 0;
+        }
+        probeStepNested(&measurement->refill, &measurement->interrupt, INTERRUPT_ENTRY_CYCLES, avr->pc, stack, cycle);
+
+        if (measurement->started ? cycle >= end : cycle >= startDeadline) {
+            break;
+        }
+    }
+    avr_terminate(avr);
+    return result;
+}
+
+/**
+ * @brief Print usage.
+ * @param[in] program : Name of the executable.
+ * @return Exit code.
+ */
+static int usage(const char *program) {
+    fprintf(stderr, "Usage: %s [--hardware-spi] [--seconds N] <firmware.elf> <card.img> <entry>...\n", program);
+    fprintf(stderr, "Entries of the card root directory are counted from 1.\n");
+    return EXIT_FAILURE;
+}
+
+/**
+ * @brief Print a row of results.
+ * @param[in] entry : Entry of the root directory.
+ * @param[in] measurement : Measured values.
+ */
+static void printMeasurement(uint16_t entry, const struct Measurement *measurement) {
+    const struct Probe *interrupt = &measurement->interrupt;
+    const struct Probe *refill = &measurement->refill;
+    if (!measurement->started || interrupt->count == 0) {
+        printf("%5u  not played\n", entry);
+        return;
+    }
+    double perSample = (double) (interrupt->total + refill->total) / interrupt->count + INTERRUPT_ENTRY_CYCLES;
+    printf("%5u %7.1f %7lu %7lu %7.0f %7lu %8.1f %7.0f %7.0f %7.0f\n", entry,
+           (double) interrupt->total / interrupt->count, (unsigned long) interrupt->worst,
+           (unsigned long) measurement->worstLatency,
+           refill->count ? (double) refill->total / refill->count : 0.0, (unsigned long) refill->worst,
+           perSample, 1e6 / perSample, 8e6 / perSample, 16e6 / perSample);
+}
+
+/**
+ * @brief Measure entries given on the command line.
+ */
+int main(int argc, char **argv) {
+    bool hardwareSpi = false;
+    uint32_t seconds = DEFAULT_SECONDS;
+    int argument = 1;
+    for (; argument < argc && strncmp(argv[argument], "--", 2) == 0; argument++) {
+        if (strcmp(argv[argument], "--hardware-spi") == 0) {
+            hardwareSpi = true;
+        }
+        else if (strcmp(argv[argument], "--seconds") == 0 && argument + 1 < argc) {
+            seconds = (uint32_t) strtoul(argv[++argument], NULL, 10);
+        }
+        else {
+            return usage(argv[0]);
+        }
+    }
+    if (argc - argument < 3) {
+        return usage(argv[0]);
+    }
+    const char *firmwarePath = argv[argument];
+    const char *imagePath = argv[argument + 1];
+
+    struct Measurement empty = {0};
+    if (!elfFindSymbol(firmwarePath, INTERRUPT_SYMBOL, &empty.interrupt.address)
+        || !elfFindSymbol(firmwarePath, REFILL_SYMBOL, &empty.refill.address)) {
+        fprintf(stderr, "No %s or %s in %s\n", INTERRUPT_SYMBOL, REFILL_SYMBOL, firmwarePath);
+        return EXIT_FAILURE;
+    }
+    elf_firmware_t firmware;
+    memset(&firmware, 0, sizeof(firmware));
+    if (elf_read_firmware(firmwarePath, &firmware) != 0) {
+        fprintf(stderr, "Can not load %s\n", firmwarePath);
+        return EXIT_FAILURE;
+    }
+
+    printf("F_CPU %lu, %s card, %lu s per entry, cycles of interrupt bodies exclude %d entry cycles\n",
+           (unsigned long) F_CPU, hardwareSpi ? "hardware SPI" : "bit-banged", (unsigned long) seconds,
+           INTERRUPT_ENTRY_CYCLES);
+    printf("entry     isr isr max latency  refill ref max  cyc/smp  max Hz at 1MHz    8MHz   16MHz\n");
+    for (; argument + 2 < argc; argument++) {
+        uint16_t entry = (uint16_t) strtoul(argv[argument + 2], NULL, 10);
+        if (!sdCardOpen(imagePath)) {
+            fprintf(stderr, "Can not open image %s\n", imagePath);
+            return EXIT_FAILURE;
+        }
+        struct Measurement measurement = empty;
+        if (entry == 0 || !measureEntry(&firmware, entry, hardwareSpi, seconds, &measurement)) {
+            printf("%5u  simulation failed\n", entry);
+        }
+        else {
+            printMeasurement(entry, &measurement);
+        }
+        printf("        card commands %lu, blocks %lu\n", (unsigned long) sdCardStats()->commands,
+               (unsigned long) sdCardStats()->blocks);
+        sdCardClose();
+    }
+    return EXIT_SUCCESS;
+}
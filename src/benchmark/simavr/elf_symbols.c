@@ -0,0 +1,88 @@
+/**
+ * @file
+ * Symbol lookup in firmware ELF file implementation, reading symbol tables of the section headers.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <elf.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "elf_symbols.h"
+
+/**
+ * @brief Read whole file.
+ * @param[in] path : File path.
+ * @param[out] size : File size.
+ * @return Allocated file contents, @p NULL on failure.
+ */
+static uint8_t *readFile(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return NULL;
+    }
+    uint8_t *contents = NULL;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long length = ftell(file);
+        contents = length > 0 ? malloc((size_t) length) : NULL;
+        rewind(file);
+        if (contents != NULL && fread(contents, (size_t) length, 1, file) != 1) {
+            free(contents);
+            contents = NULL;
+        }
+        *size = (size_t) length;
+    }
+    fclose(file);
+    return contents;
+}
+
+/**
+ * @brief Check if a range lies in the file.
+ */
+static bool inFile(size_t offset, size_t length, size_t size) {
+    return offset <= size && length <= size - offset;
+}
+
+bool elfFindSymbol(const char *path, const char *name, uint32_t *address) {
+    size_t size;
+    uint8_t *elf = readFile(path, &size);
+    if (elf == NULL) {
+        return false;
+    }
+
+    bool found = false;
+    const Elf32_Ehdr *header = (const Elf32_Ehdr *) elf;
+    if (size < sizeof(*header) || memcmp(header->e_ident, ELFMAG, SELFMAG) != 0
+        || header->e_ident[EI_CLASS] != ELFCLASS32 || header->e_shentsize != sizeof(Elf32_Shdr)
+        || !inFile(header->e_shoff, (size_t) header->e_shnum * sizeof(Elf32_Shdr), size)) {
+        free(elf);
+        return false;
+    }
+    const Elf32_Shdr *sections = (const Elf32_Shdr *) (elf + header->e_shoff);
+
+    for (uint16_t i = 0; i < header->e_shnum && !found; i++) {
+        const Elf32_Shdr *table = &sections[i];
+        if (table->sh_type != SHT_SYMTAB || table->sh_link >= header->e_shnum
+            || !inFile(table->sh_offset, table->sh_size, size)) {
+            continue;
+        }
+        const Elf32_Shdr *strings = &sections[table->sh_link];
+        if (!inFile(strings->sh_offset, strings->sh_size, size)) {
+            continue;
+        }
+        const Elf32_Sym *symbols = (const Elf32_Sym *) (elf + table->sh_offset);
+        for (size_t j = 0; j < table->sh_size / sizeof(Elf32_Sym); j++) {
+            if (symbols[j].st_name < strings->sh_size
+                && strncmp((const char *) elf + strings->sh_offset + symbols[j].st_name, name,
+                           strings->sh_size - symbols[j].st_name) == 0) {
+                *address = symbols[j].st_value;
+                found = true;
+                break;
+            }
+        }
+    }
+    free(elf);
+    return found;
+}
@@ -0,0 +1,24 @@
+/**
+ * @file
+ * Symbol lookup in firmware ELF file, to find measured functions.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __ELF_SYMBOLS_H__
+#define __ELF_SYMBOLS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Find address of a symbol.
+ * @param[in] path : Path of 32 bit little endian ELF file, e.g. avr-gcc output.
+ * @param[in] name : Symbol name.
+ * @param[out] address : Symbol value, byte address in flash for functions.
+ * @return @p true if the symbol was found, @p false otherwise.
+ */
+bool elfFindSymbol(const char *path, const char *name, uint32_t *address);
+
+#endif /* __ELF_SYMBOLS_H__ */
@@ -0,0 +1,43 @@
+/**
+ * @file
+ * Function probe of the cycle benchmark implementation.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include "probe.h"
+
+uint64_t probeStep(struct Probe *probe, uint32_t pc, uint16_t stack, uint64_t cycle) {
+    if (!probe->active) {
+        if (pc == probe->address) {
+            probe->active = true;
+            probe->entryStack = stack;
+            probe->entryCycle = cycle;
+            probe->nested = 0;
+        }
+        return 0;
+    }
+    if (stack <= probe->entryStack) {
+        return 0;
+    }
+    probe->active = false;
+    uint64_t duration = cycle - probe->entryCycle;
+    uint64_t own = duration - probe->nested;
+    probe->total += own;
+    probe->count++;
+    if (own > probe->worst) {
+        probe->worst = own;
+    }
+    return duration;
+}
+
+void probeStepNested(struct Probe *function, struct Probe *interrupt, uint8_t entryCycles, uint32_t pc,
+                     uint16_t stack, uint64_t cycle) {
+    uint64_t taken = probeStep(interrupt, pc, stack, cycle);
+    // Interrupt probe starts at the body, cycles spent on the way there belong to the interrupt too.
+    if (taken != 0 && function->active) {
+        function->nested += taken + entryCycles;
+    }
+    probeStep(function, pc, stack, cycle);
+}
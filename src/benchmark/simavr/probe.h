@@ -0,0 +1,52 @@
+/**
+ * @file
+ * Function probe of the cycle benchmark interface, timing calls from the executed addresses and the stack pointer.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __PROBE_H__
+#define __PROBE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Measured function, from its first instruction to the return from it.
+ */
+struct Probe {
+    uint32_t address; ///< Byte address of the first instruction.
+    bool active; ///< Flag indicating if the function runs.
+    uint16_t entryStack; ///< Stack pointer at the first instruction, return raises it above.
+    uint64_t entryCycle; ///< Cycle of the first instruction.
+    uint64_t nested; ///< Cycles of interrupts taken while the function runs.
+    uint64_t total; ///< Cycles of all calls, without nested interrupts.
+    uint64_t worst; ///< Cycles of the longest call, without nested interrupts.
+    uint32_t count; ///< Number of calls.
+};
+
+/**
+ * @brief Follow a probe after an instruction.
+ * @param[out] probe : Probe.
+ * @param[in] pc : Byte address of the next instruction.
+ * @param[in] stack : Stack pointer.
+ * @param[in] cycle : Current cycle.
+ * @return Duration of a call, which just returned, with nested interrupts, 0 otherwise.
+ */
+uint64_t probeStep(struct Probe *probe, uint32_t pc, uint16_t stack, uint64_t cycle);
+
+/**
+ * @brief Follow a function probe and an interrupt probe after an instruction,
+ * interrupts taken while the function runs are not counted in its cycles.
+ * @param[out] function : Probe of the function.
+ * @param[out] interrupt : Probe of the interrupt body.
+ * @param[in] entryCycles : Cycles of taking the interrupt before its body.
+ * @param[in] pc : Byte address of the next instruction.
+ * @param[in] stack : Stack pointer.
+ * @param[in] cycle : Current cycle.
+ */
+void probeStepNested(struct Probe *function, struct Probe *interrupt, uint8_t entryCycles, uint32_t pc,
+                     uint16_t stack, uint64_t cycle);
+
+#endif /* __PROBE_H__ */
@@ -0,0 +1,325 @@
+/**
+ * @file
+ * Simulated SD card implementation.
+ * Command responses are queued after one Ncr byte, read blocks follow them: latency bytes, data token,
+ * 512 data bytes and two CRC bytes. Multiple block read goes on until CMD12.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "sd_card.h"
+
+/**
+ * @brief Size of a block.
+ */
+#define BLOCK_SIZE 512
+
+/**
+ * @brief Number of bytes sent per block, see file description.
+ */
+#define BLOCK_PACKET_SIZE (SD_CARD_READ_LATENCY_BYTES + 1 + BLOCK_SIZE + 2)
+
+/**
+ * @brief Data token starting a block.
+ */
+#define DATA_TOKEN 0xFE
+
+/**
+ * @brief Size of a command packet.
+ */
+#define COMMAND_SIZE 6
+
+/**
+ * @brief Maximum number of queued response bytes: Ncr, R1 and four more bytes of R3/R7.
+ */
+#define RESPONSE_SIZE 6
+
+/**
+ * @brief R1 bit of idle state.
+ */
+#define R1_IDLE 0x01
+
+/**
+ * @brief R1 bit of illegal command.
+ */
+#define R1_ILLEGAL_COMMAND 0x04
+
+/**
+ * @brief R1 bit of parameter error.
+ */
+#define R1_PARAMETER_ERROR 0x40
+
+/**
+ * @brief Read in progress.
+ */
+enum SdCardRead {
+    SD_CARD_READ_NONE, ///< No block is sent.
+    SD_CARD_READ_SINGLE, ///< CMD17, a single block is sent.
+    SD_CARD_READ_MULTIPLE, ///< CMD18, blocks are sent until CMD12.
+};
+
+/**
+ * @brief Image read by the card, @p NULL if there is none.
+ */
+static FILE *image;
+
+/**
+ * @brief Number of blocks in @ref image.
+ */
+static uint32_t blockCount;
+
+/**
+ * @brief Chip select state.
+ */
+static bool selected;
+
+/**
+ * @brief Flag indicating if the card is in idle state, until ACMD41.
+ */
+static bool idle;
+
+/**
+ * @brief Flag indicating if the last command was CMD55, so the next one is an application command.
+ */
+static bool applicationCommand;
+
+/**
+ * @brief Command packet being received.
+ */
+static uint8_t command[COMMAND_SIZE];
+
+/**
+ * @brief Number of received bytes of @ref command.
+ */
+static uint8_t commandLength;
+
+/**
+ * @brief Queued response bytes.
+ */
+static uint8_t response[RESPONSE_SIZE];
+
+/**
+ * @brief Number of bytes in @ref response.
+ */
+static uint8_t responseLength;
+
+/**
+ * @brief Number of already sent bytes of @ref response.
+ */
+static uint8_t responsePosition;
+
+/**
+ * @brief Read in progress.
+ */
+static enum SdCardRead read;
+
+/**
+ * @brief Block being sent.
+ */
+static uint32_t readBlock;
+
+/**
+ * @brief Number of already sent bytes of the block packet.
+ */
+static uint16_t readPosition;
+
+/**
+ * @brief Data of @ref readBlock.
+ */
+static uint8_t block[BLOCK_SIZE];
+
+/**
+ * @brief Card counters.
+ */
+static struct SdCardStats stats;
+
+bool sdCardOpen(const char *path) {
+    sdCardClose();
+    image = fopen(path, "rb");
+    if (image == NULL || fseek(image, 0, SEEK_END) != 0) {
+        sdCardClose();
+        return false;
+    }
+    blockCount = (uint32_t) (ftell(image) / BLOCK_SIZE);
+    return true;
+}
+
+void sdCardClose() {
+    if (image != NULL) {
+        fclose(image);
+        image = NULL;
+    }
+    selected = false;
+    idle = true;
+    applicationCommand = false;
+    commandLength = 0;
+    responseLength = responsePosition = 0;
+    read = SD_CARD_READ_NONE;
+    stats = (struct SdCardStats) {0};
+}
+
+const struct SdCardStats *sdCardStats() {
+    return &stats;
+}
+
+void sdCardSelect(bool isSelected) {
+    selected = isSelected;
+}
+
+/**
+ * @brief Load block to send.
+ * @param[in] number : Block number.
+ * @return @p true on success, @p false if it is out of the image.
+ */
+static bool loadBlock(uint32_t number) {
+    if (number >= blockCount || fseek(image, (long) number * BLOCK_SIZE, SEEK_SET) != 0
+        || fread(block, BLOCK_SIZE, 1, image) != 1) {
+        return false;
+    }
+    readBlock = number;
+    readPosition = 0;
+    stats.blocks++;
+    return true;
+}
+
+uint8_t sdCardOutput() {
+    if (!selected) {
+        return 0xFF;
+    }
+    if (responsePosition < responseLength) {
+        return response[responsePosition];
+    }
+    if (read == SD_CARD_READ_NONE || readPosition < SD_CARD_READ_LATENCY_BYTES) {
+        return 0xFF;
+    }
+    if (readPosition == SD_CARD_READ_LATENCY_BYTES) {
+        return DATA_TOKEN;
+    }
+    if (readPosition < SD_CARD_READ_LATENCY_BYTES + 1 + BLOCK_SIZE) {
+        return block[readPosition - SD_CARD_READ_LATENCY_BYTES - 1];
+    }
+    return 0xFF; // Ignored CRC.
+}
+
+/**
+ * @brief Move past the byte returned by @ref sdCardOutput.
+ */
+static void advanceOutput() {
+    if (responsePosition < responseLength) {
+        responsePosition++;
+        return;
+    }
+    if (read == SD_CARD_READ_NONE || ++readPosition < BLOCK_PACKET_SIZE) {
+        return;
+    }
+    if (read == SD_CARD_READ_SINGLE || !loadBlock(readBlock + 1)) {
+        read = SD_CARD_READ_NONE;
+    }
+}
+
+/**
+ * @brief Queue response byte.
+ * @param[in] value : Byte to send.
+ */
+static void respond(uint8_t value) {
+    response[responseLength++] = value;
+}
+
+/**
+ * @brief Queue R1 response.
+ * @param[in] flags : Error bits.
+ */
+static void respondR1(uint8_t flags) {
+    respond((uint8_t) ((idle ? R1_IDLE : 0) | flags));
+}
+
+/**
+ * @brief Execute received command packet.
+ */
+static void execute() {
+    uint8_t index = command[0] & 0x3F;
+    uint32_t argument = (uint32_t) command[1] << 24 | (uint32_t) command[2] << 16 | (uint32_t) command[3] << 8
+                        | command[4];
+    bool application = applicationCommand;
+    applicationCommand = false;
+    stats.commands++;
+
+    responseLength = responsePosition = 0;
+    respond(0xFF); // Ncr
+    switch (index) {
+        case 0: // GO_IDLE_STATE
+            idle = true;
+            read = SD_CARD_READ_NONE;
+            respondR1(0);
+            break;
+        case 8: // SEND_IF_COND, R7 echoes voltage and check pattern.
+            respondR1(0);
+            respond(0x00);
+            respond(0x00);
+            respond((uint8_t) (argument >> 8 & 0x0F));
+            respond((uint8_t) argument);
+            break;
+        case 12: // STOP_TRANSMISSION, after a stuff byte.
+            read = SD_CARD_READ_NONE;
+            respond(0xFF);
+            respondR1(0);
+            break;
+        case 16: // SET_BLOCKLEN
+            respondR1(argument == BLOCK_SIZE ? 0 : R1_PARAMETER_ERROR);
+            break;
+        case 17: // READ_SINGLE_BLOCK
+        case 18: // READ_MULTIPLE_BLOCK
+            if (loadBlock(argument)) {
+                read = index == 17 ? SD_CARD_READ_SINGLE : SD_CARD_READ_MULTIPLE;
+                respondR1(0);
+            }
+            else {
+                read = SD_CARD_READ_NONE;
+                respondR1(R1_PARAMETER_ERROR);
+            }
+            break;
+        case 41: // SD_SEND_OP_COND, after CMD55
+            if (!application) {
+                respondR1(R1_ILLEGAL_COMMAND);
+                break;
+            }
+            idle = false;
+            respondR1(0);
+            break;
+        case 55: // APP_CMD
+            applicationCommand = true;
+            respondR1(0);
+            break;
+        case 58: // READ_OCR, powered up and high capacity.
+            respondR1(0);
+            respond(0xC0);
+            respond(0xFF);
+            respond(0x80);
+            respond(0x00);
+            break;
+        default:
+            respondR1(R1_ILLEGAL_COMMAND);
+    }
+}
+
+uint8_t sdCardExchange(uint8_t input) {
+    if (!selected) {
+        return 0xFF;
+    }
+    uint8_t output = sdCardOutput();
+    advanceOutput();
+
+    // Bytes between commands are 0xFF, a packet starts with 01 bits.
+    if (commandLength == 0 && (input & 0xC0) != 0x40) {
+        return output;
+    }
+    command[commandLength++] = input;
+    if (commandLength == COMMAND_SIZE) {
+        commandLength = 0;
+        execute();
+    }
+    return output;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file
+ * Simulated SD card interface, answering SPI mode commands of sdmm.c from a disk image.
+ * Card is an SDv2 high capacity one: block addressing, single and multiple block reads, no writes.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __SD_CARD_H__
+#define __SD_CARD_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Number of 0xFF bytes sent before every data token, access time of the card.
+ */
+#define SD_CARD_READ_LATENCY_BYTES 8
+
+/**
+ * @brief Card counters.
+ */
+struct SdCardStats {
+    uint32_t commands; ///< Number of received commands.
+    uint32_t blocks; ///< Number of sent data blocks.
+};
+
+/**
+ * @brief Open image read by the card.
+ * @param[in] path : Path of raw FAT volume image.
+ * @return @p true on success, @p false otherwise.
+ */
+bool sdCardOpen(const char *path);
+
+/**
+ * @brief Close image and reset card state.
+ */
+void sdCardClose();
+
+/**
+ * @brief Set chip select line, card ignores the bus and keeps its output high while deselected.
+ * Open multiple block read is kept, as on a real card.
+ * @param[in] selected : @p true if CS is low.
+ */
+void sdCardSelect(bool selected);
+
+/**
+ * @brief Get byte the card shifts out during the next exchange, bits of it appear on DO before clock edges.
+ * @return Next output byte.
+ */
+uint8_t sdCardOutput();
+
+/**
+ * @brief Exchange a byte: receive @p input, while @ref sdCardOutput is shifted out.
+ * @param[in] input : Byte received on DI.
+ * @return Byte shifted out on DO.
+ */
+uint8_t sdCardExchange(uint8_t input);
+
+/**
+ * @brief Get card counters.
+ * @return Pointer to counters gathered since image was opened.
+ */
+const struct SdCardStats *sdCardStats();
+
+#endif /* __SD_CARD_H__ */
@@ -0,0 +1,128 @@
+/**
+ * @file
+ * Host test of the cycle benchmark parts, which do not need simavr: symbol lookup in an AVR ELF file
+ * and timing of calls by probes over a hand-written trace of a refill interrupted by the output interrupt.
+ *
+ * Usage: cycle-benchmark-test <symbols.elf> <symbols.s>
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "../elf_symbols.h"
+#include "../probe.h"
+
+/**
+ * @brief Address of the output interrupt body in symbols.s.
+ */
+#define TEST_INTERRUPT_ADDRESS 0x56
+
+/**
+ * @brief Address of the refill in symbols.s, behind a symbol it is a prefix of.
+ */
+#define TEST_REFILL_ADDRESS 0x5C
+
+/**
+ * @brief Cycles of taking the interrupt before its body, response and jump from the vector table.
+ */
+#define TEST_ENTRY_CYCLES 7
+
+/**
+ * @brief State of the simulated microcontroller after an instruction.
+ */
+struct TraceStep {
+    uint32_t pc; ///< Byte address of the next instruction.
+    uint16_t stack; ///< Stack pointer.
+    uint64_t cycle; ///< Current cycle.
+};
+
+/**
+ * @brief Refill called with its return address pushed, calling a function of its own and interrupted once,
+ * then the interrupt taken outside of it.
+ */
+static const struct TraceStep trace[] = {
+        {0x0300, 0x085F, 990},  // Caller.
+        {0x005C, 0x085D, 1000}, // Refill entered by call.
+        {0x0060, 0x085C, 1002}, // Push.
+        {0x0080, 0x085A, 1006}, // Nested call.
+        {0x0062, 0x085C, 1010}, // Returned to refill, not above its entry stack pointer.
+        {0x001C, 0x085A, 1014}, // Interrupt response after the instruction ending at 1010, at the vector.
+        {0x0056, 0x085A, 1017}, // Jump to the interrupt body.
+        {0x0058, 0x0859, 1019}, // Push.
+        {0x005A, 0x085A, 1021}, // Pop.
+        {0x0062, 0x085C, 1025}, // Reti back to refill.
+        {0x0064, 0x085D, 1027}, // Pop.
+        {0x0302, 0x085F, 1031}, // Ret to the caller.
+        {0x001C, 0x085D, 2004}, // Interrupt response outside of refill.
+        {0x0056, 0x085D, 2007}, // Jump to the interrupt body.
+        {0x0302, 0x085F, 2017}, // Reti.
+};
+
+/**
+ * @brief Check a value, report a mismatch.
+ * @param[in] what : Name of the checked value.
+ * @param[in] value : Actual value.
+ * @param[in] expected : Expected value.
+ * @return @p true if they are equal, @p false otherwise.
+ */
+static bool check(const char *what, uint64_t value, uint64_t expected) {
+    if (value != expected) {
+        fprintf(stderr, "%s: %llu, expected %llu\n", what, (unsigned long long) value, (unsigned long long) expected);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Look up the probed symbols like the cycle benchmark does.
+ * @param[in] elfPath : AVR ELF file assembled from @p sourcePath.
+ * @param[in] sourcePath : Assembly source, not an ELF file.
+ * @return @p true on success, @p false otherwise.
+ */
+static bool testSymbols(const char *elfPath, const char *sourcePath) {
+    uint32_t interrupt = 0;
+    uint32_t refill = 0;
+    uint32_t missing = 0;
+    bool result = elfFindSymbol(elfPath, "__vector_7", &interrupt)
+                  && elfFindSymbol(elfPath, "sourceRefillBuffer", &refill);
+    result = check("__vector_7", interrupt, TEST_INTERRUPT_ADDRESS) && result;
+    result = check("sourceRefillBuffer", refill, TEST_REFILL_ADDRESS) && result;
+    result = check("fileRefillBuffer found", elfFindSymbol(elfPath, "fileRefillBuffer", &missing), false) && result;
+    result = check("non ELF file accepted", elfFindSymbol(sourcePath, "__vector_7", &missing), false) && result;
+    return result;
+}
+
+/**
+ * @brief Follow the trace by probes like the cycle benchmark does.
+ * @return @p true on success, @p false otherwise.
+ */
+static bool testProbes() {
+    struct Probe interrupt = {.address = TEST_INTERRUPT_ADDRESS};
+    struct Probe refill = {.address = TEST_REFILL_ADDRESS};
+    for (size_t i = 0; i < sizeof(trace) / sizeof(trace[0]); i++) {
+        probeStepNested(&refill, &interrupt, TEST_ENTRY_CYCLES, trace[i].pc, trace[i].stack, trace[i].cycle);
+    }
+    bool result = check("interrupt count", interrupt.count, 2);
+    result = check("interrupt total", interrupt.total, (1025 - 1017) + (2017 - 2007)) && result;
+    result = check("interrupt worst", interrupt.worst, 2017 - 2007) && result;
+    result = check("refill count", refill.count, 1) && result;
+    result = check("refill total", refill.total, (1031 - 1000) - (1025 - 1010)) && result;
+    result = check("refill active", refill.active || interrupt.active, false) && result;
+    return result;
+}
+
+/**
+ * @brief Run the tests.
+ */
+int main(int argc, char **argv) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <symbols.elf> <symbols.s>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    bool symbols = testSymbols(argv[1], argv[2]);
+    bool probes = testProbes();
+    printf("symbols %s, probes %s\n", symbols ? "ok" : "failed", probes ? "ok" : "failed");
+    return symbols && probes ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,28 @@
+; Symbols probed by the cycle benchmark at known addresses, behind the vector table of ATmega32.
+; symbols.elf is assembled from it by: llvm-mc -triple=avr -mcpu=atmega32 -filetype=obj -o symbols.elf symbols.s
+
+        .text
+        .globl  __vectors
+__vectors:
+        .rept   21
+        jmp     __bad_interrupt
+        .endr
+
+        .globl  sourceRefillBufferTail
+sourceRefillBufferTail:
+        ret
+
+        .globl  __vector_7
+__vector_7:
+        push    r24
+        pop     r24
+        reti
+
+        .globl  sourceRefillBuffer
+sourceRefillBuffer:
+        nop
+        ret
+
+        .globl  __bad_interrupt
+__bad_interrupt:
+        rjmp    __vectors
@@ -6,35 +6,50 @@
  * @date 12.06.2018
  */
 
-#include <avr/io.h>
-#include <stdlib.h>
 #include <stdbool.h>
-#include <util/delay.h>
 #include <string.h>
 #include "controller.h"
 #include "../view/view.h"
 #include "../player/wav_player.h"
+#include "../scheduler/scheduler.h"
+#include "../hal/ports.h"
+#include "../memory/pool.h"
 
 /**
  * @brief Used to navigate, moving up.
  */
-#define LEFT_BUTTON PA6
+#define LEFT_BUTTON PORTS_BUTTON_6
 
 /**
  * @brief Used to trigger change of directory, or to start playing.
  */
-#define MIDDLE_BUTTON PA5
+#define MIDDLE_BUTTON PORTS_BUTTON_5
 
 /**
  * @brief Used to navigate, moving down.
  */
-#define RIGHT_BUTTON PA4
+#define RIGHT_BUTTON PORTS_BUTTON_4
 
 /**
  * @brief Delay after button switch, to debounce it.
  */
 #define DEFAULT_BUTTON_DELAY_MILLISECONDS 50
 
+/**
+ * @brief Delay after seeking button switch, holding it jumps once per this period.
+ */
+#define SEEK_BUTTON_DELAY_MILLISECONDS 250
+
+/**
+ * @brief Period of buttons polling task.
+ */
+#define INPUT_TASK_PERIOD_MILLISECONDS 10
+
+/**
+ * @brief Period of screen updating task.
+ */
+#define UI_TASK_PERIOD_MILLISECONDS 100
+
 /**
  * @brief Available key types in device interface.
  */
@@ -42,6 +57,7 @@ enum KeyType {
     LEFT,
     MIDDLE,
     RIGHT,
+    SIDES,
     NONE,
 
     KEY_TYPE_LENGTH
@@ -52,33 +68,54 @@ enum KeyType {
  */
 struct Controller {
     struct View *view; ///< View used by controller.
-    bool running; ///< Flag indicating if controller is running.
+    struct Scheduler *scheduler; ///< Scheduler running refill, input and UI tasks.
+    uint16_t keysLockedUntil; ///< Scheduler tick, until which buttons are debounced.
     void (*eventHandlers[KEY_TYPE_LENGTH])
             (struct Controller *const controller); ///< Handlers dispatch table
 };
 
+RAM_BUDGET_CHECK(sizeof(struct Controller), CONTROLLER_RAM_BUDGET);
+
+/**
+ * @brief Storage of the only controller, there is a single set of buttons.
+ */
+static struct Controller controllerObjects[1];
+
 /**
- * @brief Handle left key pressed action - stop player and move position up.
+ * @brief Pool of @ref controllerObjects.
+ */
+static struct Pool controllers = POOL_INITIALIZER(controllerObjects);
+
+/**
+ * @brief Handle left key pressed action - rewind if playing, otherwise stop player and move position up.
  * @param[in] controller : Pointer to controller structure.
  */
 static void leftKeyPressedHandler(struct Controller *const controller) {
+    if (wavPlayerIsPlaying()) {
+        wavPlayerRewind(wavPlayerGetCurrentlyPlaying());
+        controller->keysLockedUntil = schedulerTicks() + SEEK_BUTTON_DELAY_MILLISECONDS;
+        return;
+    }
     if (wavPlayerGetCurrentlyPlaying() != NULL) {
         wavPlayerStopPlaying();
     }
     viewPositionUp(controller->view);
-    _delay_ms(DEFAULT_BUTTON_DELAY_MILLISECONDS);
 }
 
 /**
- * @brief Handle right key pressed action - stop player and move position down.
+ * @brief Handle right key pressed action - fast forward if playing, otherwise stop player and move position down.
  * @param[in] controller : Pointer to controller structure.
  */
 static void rightKeyPressedHandler(struct Controller *const controller) {
     if (wavPlayerIsPlaying()) {
+        wavPlayerFastForward(wavPlayerGetCurrentlyPlaying());
+        controller->keysLockedUntil = schedulerTicks() + SEEK_BUTTON_DELAY_MILLISECONDS;
+        return;
+    }
+    if (wavPlayerGetCurrentlyPlaying() != NULL) {
         wavPlayerStopPlaying();
     }
     viewPositionDown(controller->view);
-    _delay_ms(DEFAULT_BUTTON_DELAY_MILLISECONDS);
 }
 
 /**
@@ -86,14 +123,16 @@ static void rightKeyPressedHandler(struct Controller *const controller) {
  * @param[in] controller : Pointer to controller structure.
  */
 static void startPlayingNew(const struct Controller *controller) {
-    FIL *file = malloc(sizeof(FIL));
-    char *currentFilePath = viewGetCurrentPath(controller->view);
-    if (f_open(file, currentFilePath, FA_READ) == FR_OK) {
-        struct WavPlayer *wavPlayer = wavPlayerInit(file, controller->view);
-        wavPlayerStartPlaying(wavPlayer);
+    char currentFilePath[VIEW_PATH_SIZE];
+    viewGetCurrentPath(controller->view, currentFilePath);
+    struct WavPlayer *wavPlayer = wavPlayerInit(currentFilePath, controller->view);
+
+    if (wavPlayer == NULL) {
+        viewUnsupported(controller->view);
+        return;
     }
+    wavPlayerStartPlaying(wavPlayer);
     viewPlaying(controller->view);
-    free(currentFilePath);
 }
 
 /**
@@ -125,7 +164,21 @@ static void middleKeyPressedHandler(struct Controller *const controller) {
     else {
         switchPlayingState(controller);
     }
-    _delay_ms(DEFAULT_BUTTON_DELAY_MILLISECONDS);
+}
+
+/**
+ * @brief Handle both side keys pressed action - switch play next mode, showing it if a song is loaded.
+ * @param[in] controller : Pointer to controller structure.
+ */
+static void sideKeysPressedHandler(struct Controller *const controller) {
+    wavPlayerSetPlayNext(!wavPlayerIsPlayNext());
+    controller->keysLockedUntil = schedulerTicks() + SEEK_BUTTON_DELAY_MILLISECONDS;
+    if (wavPlayerIsPlaying()) {
+        viewPlaying(controller->view);
+    }
+    else if (wavPlayerGetCurrentlyPlaying() != NULL) {
+        viewPaused(controller->view);
+    }
 }
 
 /**
@@ -138,21 +191,23 @@ static void defaultEventHandler(struct Controller *const controller) {
 }
 
 struct Controller *controllerInit(struct View *view) {
-    DDRA &= ~(1 << LEFT_BUTTON | 1 << MIDDLE_BUTTON | 1 << RIGHT_BUTTON); // NOLINT
-    // Configuring pullups
-    PORTA |= 1 << LEFT_BUTTON | 1 << MIDDLE_BUTTON | 1 << RIGHT_BUTTON; // NOLINT
+    portsButtonsInit(LEFT_BUTTON | MIDDLE_BUTTON | RIGHT_BUTTON);
 
-    struct Controller *result = calloc(1, sizeof(struct Controller));
+    struct Controller *result = poolTake(&controllers);
+    if (result == NULL) {
+        return NULL;
+    }
     result->view = view;
     result->eventHandlers[LEFT] = leftKeyPressedHandler;
     result->eventHandlers[RIGHT] = rightKeyPressedHandler;
     result->eventHandlers[MIDDLE] = middleKeyPressedHandler;
+    result->eventHandlers[SIDES] = sideKeysPressedHandler;
     result->eventHandlers[NONE] = defaultEventHandler;
     return result;
 }
 
 void controllerDestroy(struct Controller *controller) {
-    free(controller);
+    poolGive(&controllers, controller);
 }
 
 /**
@@ -160,21 +215,70 @@ void controllerDestroy(struct Controller *controller) {
  * @return Type of currently pressed key.
  */
 static enum KeyType getKeyType() {
-    if (!(PINA & 1 << LEFT_BUTTON)) { // NOLINT
+    uint8_t pressed = portsButtonsPressed(LEFT_BUTTON | MIDDLE_BUTTON | RIGHT_BUTTON);
+    if ((pressed & (LEFT_BUTTON | RIGHT_BUTTON)) == (LEFT_BUTTON | RIGHT_BUTTON)) {
+        return SIDES;
+    }
+    if (pressed & LEFT_BUTTON) {
         return LEFT;
     }
-    if (!(PINA & 1 << MIDDLE_BUTTON)) { // NOLINT
+    if (pressed & MIDDLE_BUTTON) {
         return MIDDLE;
     }
-    if (!(PINA & 1 << RIGHT_BUTTON)) { // NOLINT
+    if (pressed & RIGHT_BUTTON) {
         return RIGHT;
     }
     return NONE;
 }
 
-void run(struct Controller *controller) {
-    controller->running = true;
-    while (controller->running) {
-        controller->eventHandlers[getKeyType()](controller);
+/**
+ * @brief Input task - dispatch pressed key, then ignore buttons until they are debounced.
+ * @param[in] context : Pointer to controller structure.
+ */
+static void inputTask(void *context) {
+    struct Controller *controller = context;
+    uint16_t now = schedulerTicks();
+    if ((int16_t) (now - controller->keysLockedUntil) < 0) {
+        return;
+    }
+
+    enum KeyType key = getKeyType();
+    if (key != NONE) {
+        controller->keysLockedUntil = now + DEFAULT_BUTTON_DELAY_MILLISECONDS; // Handler may extend it.
+    }
+    controller->eventHandlers[key](controller);
+}
+
+/**
+ * @brief UI task - update screen on changes not caused by user.
+ * @param[in] context : Pointer to controller structure.
+ */
+static void uiTask(void *context) {
+    struct Controller *controller = context;
+    if (wavPlayerTakeFinished()) {
+        viewStopped(controller->view);
     }
+    if (wavPlayerTakeTrackChanged() && wavPlayerIsPlaying()) {
+        viewPlaying(controller->view);
+    }
+}
+
+/**
+ * @brief Render task - draw requested screen rows, while audio refill keeps enough samples buffered.
+ * @param[in] context : Pointer to controller structure.
+ */
+static void renderTask(void *context) {
+    struct Controller *controller = context;
+    viewRender(controller->view);
+}
+
+void run(struct Controller *controller) {
+    controller->scheduler = schedulerInit();
+    controller->keysLockedUntil = schedulerTicks();
+    schedulerAddTask(controller->scheduler, wavPlayerRefill, NULL, 0);
+    schedulerAddTask(controller->scheduler, inputTask, controller, INPUT_TASK_PERIOD_MILLISECONDS);
+    schedulerAddTask(controller->scheduler, uiTask, controller, UI_TASK_PERIOD_MILLISECONDS);
+    schedulerAddTask(controller->scheduler, renderTask, controller, 0);
+    schedulerRun(controller->scheduler);
+    schedulerDestroy(controller->scheduler);
 }
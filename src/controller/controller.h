@@ -11,6 +11,12 @@
 #define _CONTROLLER_H__
 
 #include "../view/view.h"
+#include "../memory/ram_budget.h"
+
+/**
+ * @brief Bytes of @ref Controller.
+ */
+#define CONTROLLER_RAM_BUDGET (20 * RAM_BUDGET_SCALE)
 
 /**
  * @brief Structure representing current controller state.
@@ -20,7 +26,7 @@ struct Controller;
 /**
  * @brief Initialize @ref Controller.
  * @param[in] view : Pointer to view, which will be used.
- * @return Pointer to newly created controller.
+ * @return Pointer to newly created controller, @p NULL if the only one exists already.
  */
 struct Controller *controllerInit(struct View *view);
 
@@ -31,7 +37,7 @@ struct Controller *controllerInit(struct View *view);
 void controllerDestroy(struct Controller *controller);
 
 /**
- * @brief Active loop for events.
+ * @brief Run refill, input and UI tasks by cooperative scheduler.
  * @param[in] controller : Pointer to controller structure.
  */
 void run(struct Controller *controller);
@@ -0,0 +1,157 @@
+/**
+ * @file
+ * Text display: ST7735 through uTFT library, or a text console when HAL_HOST is defined, see src/host.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __LCD_H__
+#define __LCD_H__
+
+#include <stdint.h>
+#include "platform.h"
+
+/**
+ * @brief Display width in pixels.
+ */
+#define LCD_WIDTH 128
+
+/**
+ * @brief Display height in pixels.
+ */
+#define LCD_HEIGHT 160
+
+/**
+ * @brief Width of a text character cell in pixels, at text size 1.
+ */
+#define LCD_CHAR_WIDTH 6
+
+/**
+ * @brief Height of a text character cell in pixels, at text size 1.
+ */
+#define LCD_CHAR_HEIGHT 8
+
+/**
+ * @brief Estimated cycles of drawing a single pixel, two bytes streamed into an address window.
+ */
+#ifdef LCD_HARDWARE_SPI
+#define LCD_PIXEL_CYCLES 40
+#else
+#define LCD_PIXEL_CYCLES 120
+#endif
+
+/**
+ * @brief Pack 8 bit red, green and blue components into a 16 bit display colour.
+ */
+#define LCD_COLOR(r, g, b) ((uint16_t) ((((b) & 0xF8) << 8) | (((g) & 0xFC) << 3) | ((r) >> 3))) // NOLINT
+
+#ifdef HAL_HOST
+
+//! @cond Doxygen_Suppress
+void lcdInit();
+void lcdFillScreen(uint16_t color);
+void lcdFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+void lcdSetCursor(int16_t x, int16_t y);
+void lcdScrollArea(uint8_t y, uint8_t h);
+void lcdScrollTo(uint8_t offset);
+void lcdSetTextWrap(uint8_t wrap);
+void lcdSetTextColor(uint16_t color, uint16_t background);
+void lcdPrint(const char *text);
+void lcdWrite(uint8_t character);
+//! @endcond
+
+#else
+
+#include "../lib/uTFT-ST7735/uTFT_ST7735.h"
+
+/**
+ * @brief Initialize display.
+ */
+static inline void lcdInit() {
+    init();
+}
+
+/**
+ * @brief Fill whole display.
+ * @param[in] color : Colour, see @ref LCD_COLOR.
+ */
+static inline void lcdFillScreen(uint16_t color) {
+    fillScreen(color);
+}
+
+/**
+ * @brief Fill rectangle.
+ * @param[in] x : Left edge.
+ * @param[in] y : Top edge.
+ * @param[in] w : Width.
+ * @param[in] h : Height.
+ * @param[in] color : Colour, see @ref LCD_COLOR.
+ */
+static inline void lcdFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    fillRect(x, y, w, h, color);
+}
+
+/**
+ * @brief Move text cursor.
+ * @param[in] x : Column in pixels.
+ * @param[in] y : Row in pixels.
+ */
+static inline void lcdSetCursor(int16_t x, int16_t y) {
+    setCursor(x, y);
+}
+
+/**
+ * @brief Define vertical scrolling area of the panel, rows outside of it stay fixed. Scrolling is reset.
+ * @param[in] y : First row of the area.
+ * @param[in] h : Number of rows of the area.
+ */
+static inline void lcdScrollArea(uint8_t y, uint8_t h) {
+    setScrollArea(y, h);
+}
+
+/**
+ * @brief Scroll the area without redrawing it, rows leaving its top come back at its bottom.
+ * Drawing coordinates are not scrolled, row @p y + @p offset of the area is shown at its top.
+ * @param[in] offset : Number of rows scrolled, less than height of the area.
+ */
+static inline void lcdScrollTo(uint8_t offset) {
+    scrollTo(offset);
+}
+
+/**
+ * @brief Set wrapping of text at the right edge.
+ * @param[in] wrap : Non-zero to wrap.
+ */
+static inline void lcdSetTextWrap(uint8_t wrap) {
+    setTextWrap(wrap);
+}
+
+/**
+ * @brief Set colours of printed text.
+ * @param[in] color : Colour of characters.
+ * @param[in] background : Colour behind characters.
+ */
+static inline void lcdSetTextColor(uint16_t color, uint16_t background) {
+    setTextColor(color, background);
+}
+
+/**
+ * @brief Print text at the cursor.
+ * @param[in] text : Printed text.
+ */
+static inline void lcdPrint(const char *text) {
+    print(text);
+}
+
+/**
+ * @brief Print a single character at the cursor, new line moves it to the next row.
+ * @param[in] character : Printed character.
+ */
+static inline void lcdWrite(uint8_t character) {
+    write(character);
+}
+
+#endif /* HAL_HOST */
+
+#endif /* __LCD_H__ */
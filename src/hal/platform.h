@@ -0,0 +1,74 @@
+/**
+ * @file
+ * Platform basics: integer types, program memory tables and atomic blocks.
+ * AVR headers by default, their host equivalents when HAL_HOST is defined, see src/host.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __PLATFORM_H__
+#define __PLATFORM_H__
+
+#ifdef HAL_HOST
+
+#ifdef WAV_PLAYER_NAKED_ISR
+#error "Naked output interrupt is written in AVR assembly, it can not be built for host"
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+
+//! @cond Doxygen_Suppress
+#define PROGMEM
+#define pgm_read_byte(address) (*(const uint8_t *) (address))
+#define pgm_read_word(address) (*(const uint16_t *) (address))
+//! @endcond
+
+/**
+ * @brief Host version of avr-libc number conversion, only decimal @p radix is supported.
+ */
+static inline char *ltoa(long value, char *string, int radix) {
+    (void) radix;
+    sprintf(string, "%ld", value);
+    return string;
+}
+
+/**
+ * @brief Host version of avr-libc number conversion, only decimal @p radix is supported.
+ */
+static inline char *utoa(unsigned value, char *string, int radix) {
+    (void) radix;
+    sprintf(string, "%u", value);
+    return string;
+}
+
+/**
+ * @brief Host version of avr-libc number conversion, only decimal @p radix is supported.
+ */
+static inline char *ultoa(unsigned long value, char *string, int radix) {
+    (void) radix;
+    sprintf(string, "%lu", value);
+    return string;
+}
+
+/**
+ * @brief Interrupts are run by the host main loop between tasks, so no block needs protection.
+ */
+#define ATOMIC_BLOCK(type) for (uint8_t atomicOnce = 1; atomicOnce; atomicOnce = 0)
+
+/**
+ * @brief Unused argument of @ref ATOMIC_BLOCK.
+ */
+#define ATOMIC_RESTORESTATE 0
+
+#else
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+
+#endif /* HAL_HOST */
+
+#endif /* __PLATFORM_H__ */
@@ -0,0 +1,84 @@
+/**
+ * @file
+ * General purpose ports: buttons on port A and outputs of port B.
+ * On host buttons are pressed by its main loop, see src/host.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __PORTS_H__
+#define __PORTS_H__
+
+#include <stdint.h>
+#include "platform.h"
+
+#ifdef HAL_HOST
+
+/**
+ * @brief Mask of buttons pressed on host.
+ */
+extern uint8_t hostButtons;
+
+//! @cond Doxygen_Suppress
+#define PORTS_BUTTON_4 (1 << 4)
+#define PORTS_BUTTON_5 (1 << 5)
+#define PORTS_BUTTON_6 (1 << 6)
+
+static inline void portsInit() {
+}
+
+static inline void portsButtonsInit(uint8_t buttons) {
+    (void) buttons;
+}
+
+static inline uint8_t portsButtonsPressed(uint8_t buttons) {
+    return hostButtons & buttons;
+}
+//! @endcond
+
+#else
+
+/**
+ * @brief Button on PA4.
+ */
+#define PORTS_BUTTON_4 (1 << PA4)
+
+/**
+ * @brief Button on PA5.
+ */
+#define PORTS_BUTTON_5 (1 << PA5)
+
+/**
+ * @brief Button on PA6.
+ */
+#define PORTS_BUTTON_6 (1 << PA6)
+
+/**
+ * @brief Configure port B as output, for the display and the SD card.
+ */
+static inline void portsInit() {
+    DDRB = 0xff; // All B pins to output mode.
+}
+
+/**
+ * @brief Configure buttons as inputs with pullups, they short pins to ground when pressed.
+ * @param[in] buttons : Mask of buttons, e.g. @ref PORTS_BUTTON_4.
+ */
+static inline void portsButtonsInit(uint8_t buttons) {
+    DDRA &= ~buttons; // NOLINT
+    PORTA |= buttons; // NOLINT
+}
+
+/**
+ * @brief Get pressed buttons.
+ * @param[in] buttons : Mask of examined buttons.
+ * @return Mask of those buttons, which are pressed.
+ */
+static inline uint8_t portsButtonsPressed(uint8_t buttons) {
+    return (uint8_t) (~PINA & buttons); // NOLINT
+}
+
+#endif /* HAL_HOST */
+
+#endif /* __PORTS_H__ */
@@ -0,0 +1,56 @@
+/**
+ * @file
+ * Scheduler clock counter and timestamps.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include "timers.h"
+
+/**
+ * @brief Scheduler clock, incremented by timer interrupt.
+ */
+static volatile uint16_t ticks;
+
+/**
+ * @brief Scheduler clock interrupt.
+ */
+TIMERS_TICK_INTERRUPT {
+    ticks++;
+}
+
+uint16_t timersTicks() {
+    uint16_t result;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        result = ticks;
+    }
+    return result;
+}
+
+#ifdef HAL_HOST
+
+uint16_t timersTimestamp() {
+    return (uint16_t) (ticks * hostTimers.tickPeriod);
+}
+
+#else
+
+uint16_t timersTimestamp() {
+    uint16_t tick;
+    uint8_t count;
+    bool pending;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        tick = ticks;
+        count = TCNT0;
+        pending = TIFR & (1 << OCF0); // NOLINT
+    }
+    // Counter was cleared on compare match, while its interrupt waits for the atomic block to end.
+    if (pending && count < OCR0 / 2) {
+        tick++;
+    }
+    // Period of the clock times 65536 ticks is a multiple of 65536, so the product wraps around consistently.
+    return (uint16_t) (tick * (OCR0 + 1U) + count);
+}
+
+#endif /* HAL_HOST */
@@ -0,0 +1,175 @@
+/**
+ * @file
+ * Timers: TIMER1 sample clock of the output and TIMER0 scheduler clock, which also timestamps disk I/O.
+ * On host they are run by its main loop, see src/host.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __TIMERS_H__
+#define __TIMERS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "platform.h"
+
+/**
+ * @brief Prescaler of the scheduler clock timer.
+ */
+#define TIMERS_TICK_PRESCALER 64
+
+/**
+ * @brief Get scheduler clock.
+ * @return Scheduler clock interrupts since start, wrapping around.
+ */
+uint16_t timersTicks();
+
+/**
+ * @brief Get timestamp of the scheduler clock, in units of @ref TIMERS_TICK_PRESCALER CPU cycles.
+ * Differences of timestamps are valid up to 65535 units, half a second at 8MHz, and only while the clock runs.
+ * @return Scheduler clock ticks and its counter combined, wrapping around.
+ */
+uint16_t timersTimestamp();
+
+#ifdef HAL_HOST
+
+/**
+ * @brief Sample clock interrupt handler definition, called by host main loop once per sample.
+ */
+#define TIMERS_SAMPLE_CLOCK_INTERRUPT void timersSampleClockInterrupt(void)
+
+/**
+ * @brief Scheduler clock interrupt handler definition, called by host main loop.
+ */
+#define TIMERS_TICK_INTERRUPT void timersTickInterrupt(void)
+
+TIMERS_SAMPLE_CLOCK_INTERRUPT;
+
+TIMERS_TICK_INTERRUPT;
+
+/**
+ * @brief State of host timers, read by host main loop.
+ */
+struct HostTimers {
+    uint16_t samplePeriod; ///< Cycles between samples, 0 if sample clock is stopped.
+    bool sampleInterruptEnabled; ///< Flag indicating if sample clock interrupt is enabled.
+    bool tickRunning; ///< Flag indicating if scheduler clock is running.
+    uint8_t tickPeriod; ///< Timestamp units between scheduler clock interrupts.
+};
+
+/**
+ * @brief Host timers, defined by host main.
+ */
+extern struct HostTimers hostTimers;
+
+static inline void timersSampleClockStart(uint16_t period) {
+    hostTimers.samplePeriod = period;
+}
+
+static inline void timersSampleClockStop() {
+    hostTimers.samplePeriod = 0;
+}
+
+static inline void timersSampleInterruptEnable() {
+    hostTimers.sampleInterruptEnabled = true;
+}
+
+static inline void timersSampleInterruptDisable() {
+    hostTimers.sampleInterruptEnabled = false;
+}
+
+static inline void timersTickStart(uint16_t ticksPerSecond) {
+    hostTimers.tickPeriod = (uint8_t) (F_CPU / TIMERS_TICK_PRESCALER / ticksPerSecond);
+    hostTimers.tickRunning = true;
+}
+
+static inline void timersTickStop() {
+    hostTimers.tickRunning = false;
+}
+
+static inline bool timersTickIsRunning() {
+    return hostTimers.tickRunning;
+}
+
+static inline void timersInterruptsEnable() {
+}
+
+#else
+
+/**
+ * @brief Sample clock interrupt handler definition.
+ */
+#define TIMERS_SAMPLE_CLOCK_INTERRUPT ISR(TIMER1_COMPA_vect)
+
+/**
+ * @brief Scheduler clock interrupt handler definition.
+ */
+#define TIMERS_TICK_INTERRUPT ISR(TIMER0_COMP_vect)
+
+/**
+ * @brief Start sample clock: TIMER1 in CTC mode without prescaler.
+ * @param[in] period : Number of CPU cycles between samples.
+ */
+static inline void timersSampleClockStart(uint16_t period) {
+    TCCR1B = 1 << CS10 | 1 << WGM12; // NOLINT
+    OCR1A = period - 1;
+}
+
+/**
+ * @brief Stop sample clock.
+ */
+static inline void timersSampleClockStop() {
+    TCCR1B = 0;
+}
+
+/**
+ * @brief Enable sample clock interrupt.
+ */
+static inline void timersSampleInterruptEnable() {
+    TIMSK |= 1 << OCIE1A; // NOLINT
+}
+
+/**
+ * @brief Disable sample clock interrupt, sample clock keeps running.
+ */
+static inline void timersSampleInterruptDisable() {
+    TIMSK &= ~(1 << OCIE1A); // NOLINT
+}
+
+/**
+ * @brief Start scheduler clock: TIMER0 in CTC mode, with its interrupt.
+ * @param[in] ticksPerSecond : Frequency of interrupts.
+ */
+static inline void timersTickStart(uint16_t ticksPerSecond) {
+    TCCR0 = 1 << CS00 | 1 << CS01 | 1 << WGM01; // NOLINT
+    OCR0 = (uint8_t) (F_CPU / TIMERS_TICK_PRESCALER / ticksPerSecond - 1);
+    TIMSK |= 1 << OCIE0; // NOLINT
+}
+
+/**
+ * @brief Stop scheduler clock and its interrupt.
+ */
+static inline void timersTickStop() {
+    TIMSK &= ~(1 << OCIE0); // NOLINT
+    TCCR0 = 0;
+}
+
+/**
+ * @brief Check if scheduler clock is running, so its timestamps advance.
+ * @return @p true if it is running, @p false otherwise.
+ */
+static inline bool timersTickIsRunning() {
+    return TCCR0 != 0;
+}
+
+/**
+ * @brief Enable interrupts globally.
+ */
+static inline void timersInterruptsEnable() {
+    sei();
+}
+
+#endif /* HAL_HOST */
+
+#endif /* __TIMERS_H__ */
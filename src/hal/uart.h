@@ -0,0 +1,74 @@
+/**
+ * @file
+ * Transmit only USART on TXD (PD1), available when PORTD is not taken by the R2R DAC.
+ * On host characters are written to standard error.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __UART_H__
+#define __UART_H__
+
+#include "platform.h"
+
+#if defined(HAL_HOST) || defined(AUDIO_OUTPUT_PWM)
+
+/**
+ * @brief Defined when UART can be used, R2R DAC takes whole PORTD including TXD.
+ */
+#define UART_AVAILABLE
+
+/**
+ * @brief Baud rate of UART, 8N1 framing.
+ */
+#define UART_BAUD_RATE 38400UL
+
+#ifdef HAL_HOST
+
+//! @cond Doxygen_Suppress
+static inline void uartInit() {
+}
+
+static inline void uartWrite(char character) {
+    fputc(character, stderr);
+}
+//! @endcond
+
+#else
+
+/**
+ * @brief Initialize USART transmitter, receiver stays off.
+ */
+static inline void uartInit() {
+    uint16_t divider = (uint16_t) ((F_CPU + 8 * UART_BAUD_RATE) / (16 * UART_BAUD_RATE) - 1);
+    UBRRH = (uint8_t) (divider >> 8); // NOLINT
+    UBRRL = (uint8_t) divider;
+    UCSRB = 1 << TXEN; // NOLINT
+    UCSRC = 1 << URSEL | 1 << UCSZ1 | 1 << UCSZ0; // NOLINT
+}
+
+/**
+ * @brief Send a character, waiting for room in the transmit register.
+ * @param[in] character : Character to send.
+ */
+static inline void uartWrite(char character) {
+    loop_until_bit_is_set(UCSRA, UDRE);
+    UDR = character;
+}
+
+#endif /* HAL_HOST */
+
+/**
+ * @brief Send a string, waiting until all but its last character are sent.
+ * @param[in] string : Null-terminated string.
+ */
+static inline void uartPrint(const char *string) {
+    while (*string) {
+        uartWrite(*string++);
+    }
+}
+
+#endif /* HAL_HOST || AUDIO_OUTPUT_PWM */
+
+#endif /* __UART_H__ */
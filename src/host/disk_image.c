@@ -0,0 +1,152 @@
+/**
+ * @file
+ * Disk image implementation, same disk functions as sdmm.c, including multiple block read streams.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <stdio.h>
+#include "disk_image.h"
+#include "../lib/fat-fs/ff.h"
+#include "../lib/fat-fs/diskio.h"
+
+/**
+ * @brief Opened image, @p NULL if there is none.
+ */
+static FILE *image;
+
+/**
+ * @brief Number of sectors in @ref image.
+ */
+static DWORD sectorCount;
+
+/**
+ * @brief Sector read by the next stream read.
+ */
+static DWORD streamSector;
+
+/**
+ * @brief Flag indicating if a stream is open.
+ */
+static bool streaming;
+
+/**
+ * @brief Access counters.
+ */
+static struct DiskImageStats stats;
+
+bool diskImageOpen(const char *path) {
+    image = fopen(path, "rb");
+    if (image == NULL) {
+        return false;
+    }
+    if (fseek(image, 0, SEEK_END) != 0) {
+        diskImageClose();
+        return false;
+    }
+    sectorCount = (DWORD) (ftell(image) / FF_MAX_SS);
+    streaming = false;
+    stats = (struct DiskImageStats) {0};
+    return true;
+}
+
+void diskImageClose() {
+    if (image != NULL) {
+        fclose(image);
+        image = NULL;
+    }
+}
+
+const struct DiskImageStats *diskImageStats() {
+    return &stats;
+}
+
+/**
+ * @brief Read sectors from image.
+ * @param[out] buff : Data buffer of @p count sectors.
+ * @param[in] sector : First sector.
+ * @param[in] count : Number of sectors.
+ * @return @p RES_OK on success, @p RES_ERROR if sectors are out of the image.
+ */
+static DRESULT readSectors(BYTE *buff, DWORD sector, UINT count) {
+    if (sector + count > sectorCount || fseek(image, (long) sector * FF_MAX_SS, SEEK_SET) != 0) {
+        return RES_ERROR;
+    }
+    if (fread(buff, FF_MAX_SS, count, image) != count) {
+        return RES_ERROR;
+    }
+    stats.sectors += count;
+    return RES_OK;
+}
+
+DSTATUS disk_initialize(BYTE pdrv) {
+    return disk_status(pdrv);
+}
+
+DSTATUS disk_status(BYTE pdrv) {
+    if (pdrv || image == NULL) {
+        return STA_NOINIT;
+    }
+    return STA_PROTECT;
+}
+
+DRESULT disk_read(BYTE pdrv, BYTE *buff, DWORD sector, UINT count) {
+    if (disk_status(pdrv) & STA_NOINIT) {
+        return RES_NOTRDY;
+    }
+    // Like sdmm.c, the stream is left open, so reading the following sectors costs no command.
+    if (!streaming || sector != streamSector) {
+        disk_stream_open(pdrv, sector);
+    }
+    DRESULT result = readSectors(buff, sector, count);
+    streamSector = sector + count;
+    return result;
+}
+
+DRESULT disk_ioctl(BYTE pdrv, BYTE cmd, void *buff) {
+    if (disk_status(pdrv) & STA_NOINIT) {
+        return RES_NOTRDY;
+    }
+    switch (cmd) {
+        case CTRL_SYNC:
+            return RES_OK;
+        case GET_SECTOR_COUNT:
+            *(DWORD *) buff = sectorCount;
+            return RES_OK;
+        case GET_SECTOR_SIZE:
+            *(WORD *) buff = FF_MAX_SS;
+            return RES_OK;
+        default:
+            return RES_PARERR;
+    }
+}
+
+DRESULT disk_stream_open(BYTE pdrv, DWORD sector) {
+    if (disk_status(pdrv) & STA_NOINIT) {
+        return RES_NOTRDY;
+    }
+    disk_stream_close(pdrv);
+    streamSector = sector;
+    streaming = true;
+    stats.commands++;
+    return RES_OK;
+}
+
+DRESULT disk_stream_read(BYTE pdrv, BYTE *buff) {
+    if (disk_status(pdrv) & STA_NOINIT) {
+        return RES_NOTRDY;
+    }
+    if (!streaming) {
+        return RES_PARERR;
+    }
+    return readSectors(buff, streamSector++, 1);
+}
+
+DRESULT disk_stream_close(BYTE pdrv) {
+    if (pdrv) {
+        return RES_PARERR;
+    }
+    streaming = false;
+    return RES_OK;
+}
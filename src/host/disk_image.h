@@ -0,0 +1,41 @@
+/**
+ * @file
+ * Disk image interface, FatFs disk driver of host build reading sectors from a file instead of SD card.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __DISK_IMAGE_H__
+#define __DISK_IMAGE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Disk access counters, counterpart of SD card commands.
+ */
+struct DiskImageStats {
+    uint32_t commands; ///< Number of opened streams, each a multiple block read command on SD card.
+    uint32_t sectors; ///< Number of read sectors.
+};
+
+/**
+ * @brief Open image used by disk functions as drive 0.
+ * @param[in] path : Path of raw FAT volume image, without partition table or with one, as FatFs finds it.
+ * @return @p true on success, @p false otherwise.
+ */
+bool diskImageOpen(const char *path);
+
+/**
+ * @brief Close image opened by @ref diskImageOpen.
+ */
+void diskImageClose();
+
+/**
+ * @brief Get disk access counters.
+ * @return Pointer to counters gathered since image was opened.
+ */
+const struct DiskImageStats *diskImageStats();
+
+#endif /* __DISK_IMAGE_H__ */
@@ -0,0 +1,141 @@
+/**
+ * @file
+ * Host side of the hardware abstraction layer implementation.
+ * Display is a character grid, text is laid out as uTFT does it with its 6x8 font, colours are ignored.
+ * Vertical scrolling is applied when the grid is printed, as the panel applies it when showing its memory.
+ * Drawing runs the sample clock for its estimated cycles, as output interrupt keeps playing while device draws.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <string.h>
+#include "hal_host.h"
+
+struct HostTimers hostTimers;
+
+uint8_t hostButtons;
+
+/**
+ * @brief CPU cycles elapsed since the last sample clock interrupt.
+ */
+static uint32_t sampleClockCycles;
+
+/**
+ * @brief Characters shown by the display console.
+ */
+static char screen[HAL_HOST_ROWS][HAL_HOST_COLUMNS];
+
+/**
+ * @brief Text cursor in pixels.
+ */
+static int16_t cursorX, cursorY;
+
+/**
+ * @brief Flag indicating if text wraps at the right edge.
+ */
+static uint8_t textWrap = 1;
+
+/**
+ * @brief Vertical scrolling area and its scroll, in pixels.
+ */
+static uint8_t scrollY, scrollHeight, scrollOffset;
+
+void halHostRunSampleClock(uint32_t cycles) {
+    if (hostTimers.samplePeriod == 0) {
+        sampleClockCycles = 0;
+        return;
+    }
+    sampleClockCycles += cycles;
+    while (sampleClockCycles >= hostTimers.samplePeriod) {
+        sampleClockCycles -= hostTimers.samplePeriod;
+        // Interrupt may stop the clock, when the song ends.
+        if (hostTimers.sampleInterruptEnabled) {
+            timersSampleClockInterrupt();
+        }
+        if (hostTimers.samplePeriod == 0) {
+            sampleClockCycles = 0;
+            return;
+        }
+    }
+}
+
+void halHostDumpScreen(FILE *output) {
+    for (uint8_t row = 0; row < HAL_HOST_ROWS; row++) {
+        uint8_t y = (uint8_t) (row * LCD_CHAR_HEIGHT);
+        if (y >= scrollY && y < scrollY + scrollHeight) {
+            y = (uint8_t) (scrollY + (y - scrollY + scrollOffset) % scrollHeight);
+        }
+        fprintf(output, "|%.*s|\n", HAL_HOST_COLUMNS, screen[y / LCD_CHAR_HEIGHT]);
+    }
+}
+
+void lcdInit() {
+    lcdFillScreen(0);
+}
+
+void lcdFillScreen(uint16_t color) {
+    lcdFillRect(0, 0, LCD_WIDTH, LCD_HEIGHT, color);
+}
+
+void lcdFillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+    (void) color;
+    halHostRunSampleClock((uint32_t) w * h * LCD_PIXEL_CYCLES);
+    for (int16_t row = y / 8; row < (y + h + 7) / 8 && row < HAL_HOST_ROWS; row++) {
+        for (int16_t column = x / 6; column < (x + w + 5) / 6 && column < HAL_HOST_COLUMNS; column++) {
+            if (row >= 0 && column >= 0) {
+                screen[row][column] = ' ';
+            }
+        }
+    }
+}
+
+void lcdSetCursor(int16_t x, int16_t y) {
+    cursorX = x;
+    cursorY = y;
+}
+
+void lcdScrollArea(uint8_t y, uint8_t h) {
+    scrollY = y;
+    scrollHeight = h;
+    scrollOffset = 0;
+}
+
+void lcdScrollTo(uint8_t offset) {
+    scrollOffset = offset;
+}
+
+void lcdSetTextWrap(uint8_t wrap) {
+    textWrap = wrap;
+}
+
+void lcdSetTextColor(uint16_t color, uint16_t background) {
+    (void) color;
+    (void) background;
+}
+
+void lcdPrint(const char *text) {
+    while (*text) {
+        lcdWrite((uint8_t) *text++);
+    }
+}
+
+void lcdWrite(uint8_t character) {
+    if (character == '\n') {
+        cursorY += 8;
+        cursorX = 0;
+        return;
+    }
+    if (character == '\r') {
+        return;
+    }
+    halHostRunSampleClock((uint32_t) LCD_CHAR_WIDTH * LCD_CHAR_HEIGHT * LCD_PIXEL_CYCLES);
+    if (cursorX >= 0 && cursorX < LCD_WIDTH && cursorY >= 0 && cursorY < LCD_HEIGHT) {
+        screen[cursorY / 8][cursorX / 6] = (char) (character >= ' ' && character < 0x7f ? character : '?');
+    }
+    cursorX += 6;
+    if (textWrap && cursorX > LCD_WIDTH - 6) {
+        cursorY += 8;
+        cursorX = 0;
+    }
+}
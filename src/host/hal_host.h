@@ -0,0 +1,40 @@
+/**
+ * @file
+ * Host side of the hardware abstraction layer: timers run by the main loop, buttons and display console.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __HAL_HOST_H__
+#define __HAL_HOST_H__
+
+#include <stdio.h>
+#include "../hal/timers.h"
+#include "../hal/ports.h"
+#include "../hal/lcd.h"
+
+/**
+ * @brief Number of text columns of the display console, characters are 6 pixels wide.
+ */
+#define HAL_HOST_COLUMNS (LCD_WIDTH / LCD_CHAR_WIDTH)
+
+/**
+ * @brief Number of text rows of the display console, characters are 8 pixels high.
+ */
+#define HAL_HOST_ROWS (LCD_HEIGHT / LCD_CHAR_HEIGHT)
+
+/**
+ * @brief Run sample clock interrupts falling into a number of CPU cycles, if the clock and its interrupt are on.
+ * Cycles left after the last sample are carried to the next call.
+ * @param[in] cycles : Number of CPU cycles.
+ */
+void halHostRunSampleClock(uint32_t cycles);
+
+/**
+ * @brief Print display console contents.
+ * @param[out] output : Stream to print to.
+ */
+void halHostDumpScreen(FILE *output);
+
+#endif /* __HAL_HOST_H__ */
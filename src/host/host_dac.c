@@ -0,0 +1,48 @@
+/**
+ * @file
+ * Virtual DAC implementation.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <stdio.h>
+#include "host_dac.h"
+#include "../player/audio_output.h"
+
+/**
+ * @brief Recording file, @p NULL if samples are only counted.
+ */
+static FILE *recording;
+
+/**
+ * @brief Number of played samples.
+ */
+static uint32_t samples;
+
+bool hostDacOpen(const char *path) {
+    samples = 0;
+    if (path == NULL) {
+        return true;
+    }
+    recording = fopen(path, "wb");
+    return recording != NULL;
+}
+
+void hostDacClose() {
+    if (recording != NULL) {
+        fclose(recording);
+        recording = NULL;
+    }
+}
+
+uint32_t hostDacSamples() {
+    return samples;
+}
+
+void hostDacWrite(uint8_t sample) {
+    samples++;
+    if (recording != NULL) {
+        fputc(sample, recording);
+    }
+}
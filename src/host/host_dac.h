@@ -0,0 +1,33 @@
+/**
+ * @file
+ * Virtual DAC interface, sink of samples played by host build.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __HOST_DAC_H__
+#define __HOST_DAC_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Open file recording played samples, as raw unsigned 8 bit mono.
+ * @param[in] path : Path of created file, @p NULL to only count samples.
+ * @return @p true on success, @p false otherwise.
+ */
+bool hostDacOpen(const char *path);
+
+/**
+ * @brief Close recording file.
+ */
+void hostDacClose();
+
+/**
+ * @brief Get number of samples played since the DAC was opened.
+ * @return Number of samples.
+ */
+uint32_t hostDacSamples();
+
+#endif /* __HOST_DAC_H__ */
@@ -0,0 +1,138 @@
+/**
+ * @file
+ * Entrypoint of host build: plays a song from a FAT image into the virtual DAC, as fast as possible.
+ * Main loop stands in for the scheduler: every millisecond of simulated time it runs the refill and render tasks,
+ * then the sample clock interrupts of that millisecond.
+ *
+ * Usage: wav-player-host <image> <directory> <index> <output.raw|-> [play-next]
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hal_host.h"
+#include "host_dac.h"
+#include "disk_image.h"
+#include "../view/view.h"
+#include "../player/wav_player.h"
+#include "../lib/fat-fs/ff.h"
+
+/**
+ * @brief Simulated time between main loop iterations, scheduler clock tick.
+ */
+#define TICKS_PER_SECOND 1000
+
+/**
+ * @brief Limit of simulated time, in case the player never finishes.
+ */
+#define MAXIMUM_SECONDS 3600UL
+
+/**
+ * @brief Print usage.
+ * @param[in] program : Name of the executable.
+ * @return Exit code.
+ */
+static int usage(const char *program) {
+    fprintf(stderr, "Usage: %s <image> <directory> <index> <output.raw|-> [play-next]\n", program);
+    fprintf(stderr, "Plays entry <index> of <directory> listing, counted from 0, '-' only counts samples.\n");
+    return EXIT_FAILURE;
+}
+
+/**
+ * @brief Draw all rows of requested screen, left undrawn while playing.
+ * @param[out] view : Pointer to view.
+ */
+static void renderAll(struct View *view) {
+    while (viewRender(view) && !wavPlayerIsPlaying()) {
+    }
+}
+
+/**
+ * @brief Play the song, print screen and statistics.
+ * @param[in] view : View with the song selected.
+ * @return Exit code.
+ */
+static int play(struct View *view) {
+    char path[VIEW_PATH_SIZE];
+    viewGetCurrentPath(view, path);
+    struct WavPlayer *player = wavPlayerInit(path, view);
+    if (player == NULL) {
+        viewUnsupported(view);
+        renderAll(view);
+        halHostDumpScreen(stdout);
+        fprintf(stderr, "Can not play %s\n", path);
+        return EXIT_FAILURE;
+    }
+    wavPlayerStartPlaying(player);
+    viewPlaying(view);
+
+    clock_t start = clock();
+    uint32_t ticks = 0;
+    while (!wavPlayerTakeFinished() && ticks < MAXIMUM_SECONDS * TICKS_PER_SECOND) {
+        wavPlayerRefill(NULL);
+        viewRender(view);
+        halHostRunSampleClock(F_CPU / TICKS_PER_SECOND);
+        timersTickInterrupt();
+        if (wavPlayerTakeTrackChanged() && wavPlayerIsPlaying()) {
+            viewPlaying(view);
+        }
+        ticks++;
+    }
+    double seconds = (double) (clock() - start) / CLOCKS_PER_SEC;
+
+    renderAll(view);
+    halHostDumpScreen(stdout);
+    const struct PlaybackStats *stats = wavPlayerGetStats();
+    const struct DiskImageStats *disk = diskImageStats();
+    printf("samples %lu, simulated %lu ms, host %.3f s\n", (unsigned long) hostDacSamples(), (unsigned long) ticks,
+           seconds);
+    printf("underruns %u, near misses %u, minimum fill %u, refills %u\n", stats->underruns, stats->nearMisses,
+           stats->minimumFill, stats->refills);
+    printf("frame time %u ms\n", viewFrameTime(view));
+    printf("disk commands %lu, sectors %lu\n", (unsigned long) disk->commands, (unsigned long) disk->sectors);
+    wavPlayerStopPlaying();
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Mount image, select the song and play it.
+ */
+int main(int argc, char **argv) {
+    if (argc < 5 || argc > 6 || (argc == 6 && strcmp(argv[5], "play-next") != 0)) {
+        return usage(argv[0]);
+    }
+    if (!diskImageOpen(argv[1])) {
+        fprintf(stderr, "Can not open image %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    if (!hostDacOpen(strcmp(argv[4], "-") == 0 ? NULL : argv[4])) {
+        fprintf(stderr, "Can not create %s\n", argv[4]);
+        diskImageClose();
+        return EXIT_FAILURE;
+    }
+
+    FATFS fatFs;
+    int result = EXIT_FAILURE;
+    if (f_mount(&fatFs, "", 1) != FR_OK) {
+        fprintf(stderr, "No FAT volume in %s\n", argv[1]);
+    } else {
+        struct View *view = viewInit(argv[2]);
+        viewAvailableSongs(view);
+        // Position grows up the list, as the left button moves it.
+        for (long index = strtol(argv[3], NULL, 10); index > 0; index--) {
+            viewPositionUp(view);
+        }
+        wavPlayerSetPlayNext(argc == 6);
+        result = play(view);
+        viewDestroy(view);
+        f_unmount("");
+    }
+
+    hostDacClose();
+    diskImageClose();
+    return result;
+}
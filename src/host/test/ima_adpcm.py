@@ -0,0 +1,70 @@
+#!/usr/bin/env python3
+"""Generate IMA ADPCM test song and its reference decoding for ima_adpcm_test.c.
+
+Blocks are encoded and decoded by the DVI ADPCM codec of Python audioop module (Python 3.12 or older),
+which is the same algorithm, with nibbles in the other order within a byte. Reference samples are high bytes
+of decoded ones, biased to unsigned 8 bit, as the player outputs them.
+
+Usage: ima_adpcm.py <song.wav> <reference.raw>
+"""
+
+import audioop
+import math
+import struct
+import sys
+
+RATE = 16000
+# Odd block size, so that block headers fall across 128 byte refill reads.
+BLOCK_ALIGN = 101
+BLOCKS = 48
+SAMPLES_PER_BLOCK = (BLOCK_ALIGN - 4) * 2 + 1
+
+
+def signal(count):
+    """Sweep with a few steps, exercising small and large quantizer steps."""
+    result = []
+    for i in range(count):
+        t = i / RATE
+        value = 0.6 * math.sin(2 * math.pi * (200 + 3000 * t) * t)
+        if (i // 1500) % 2:
+            value += 0.35
+        result.append(max(-32768, min(32767, int(value * 32767))))
+    return result
+
+
+def swap_nibbles(data):
+    return bytes(((b << 4) | (b >> 4)) & 0xff for b in data)
+
+
+def main(song_path, reference_path):
+    pcm = signal(BLOCKS * SAMPLES_PER_BLOCK)
+    data = bytearray()
+    reference = bytearray()
+    index = 0
+    for block in range(BLOCKS):
+        samples = pcm[block * SAMPLES_PER_BLOCK:(block + 1) * SAMPLES_PER_BLOCK]
+        first = samples[0]
+        body = struct.pack('<%dh' % (len(samples) - 1), *samples[1:])
+        encoded, (_, next_index) = audioop.lin2adpcm(body, 2, (first, index))
+        data += struct.pack('<hBB', first, index, 0) + swap_nibbles(encoded)
+
+        decoded, _ = audioop.adpcm2lin(encoded, 2, (first, index))
+        values = [first] + list(struct.unpack('<%dh' % (len(decoded) // 2), decoded))
+        reference += bytes(((value >> 8) & 0xff) ^ 0x80 for value in values)
+        index = next_index
+
+    fmt = struct.pack('<HHIIHHHH', 0x11, 1, RATE, RATE * BLOCK_ALIGN // SAMPLES_PER_BLOCK, BLOCK_ALIGN, 4, 2,
+                      SAMPLES_PER_BLOCK)
+    body = b'WAVE' + b'fmt ' + struct.pack('<I', len(fmt)) + fmt
+    body += b'fact' + struct.pack('<II', 4, len(reference))
+    body += b'data' + struct.pack('<I', len(data)) + bytes(data)
+    with open(song_path, 'wb') as song:
+        song.write(b'RIFF' + struct.pack('<I', len(body)) + body)
+    with open(reference_path, 'wb') as raw:
+        raw.write(reference)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    main(sys.argv[1], sys.argv[2])
@@ -0,0 +1,174 @@
+/**
+ * @file
+ * Host test of IMA ADPCM decoding through playback buffer refills, against reference samples.
+ * Song data is served by a sector source over a file read to memory, in refill sized reads, so block headers
+ * of its odd sized blocks fall across refills. Reference is decoded by another implementation, see ima_adpcm.py.
+ *
+ * Usage: ima-adpcm-test <song.wav> <reference.raw>
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../../player/playback_buffer.h"
+#include "../../player/sample_decoder.h"
+#include "../../player/sector_source.h"
+
+/**
+ * @brief Maximum size of test files.
+ */
+#define TEST_FILE_SIZE 65536
+
+/**
+ * @brief Format tag of IMA ADPCM.
+ */
+#define TEST_FORMAT_IMA_ADPCM 0x11
+
+/**
+ * @brief Sector source over song data in memory.
+ */
+struct SectorSource {
+    const uint8_t *data; ///< Whole song file.
+    FSIZE_t position; ///< Offset of the next read.
+    FSIZE_t end; ///< End of song data.
+    uint32_t splitHeaders; ///< Number of reads ending within a block header.
+    uint16_t blockAlign; ///< Block size, for counting split headers.
+    FSIZE_t dataOffset; ///< Beginning of the first block.
+};
+
+void sectorSourceSeek(struct SectorSource *source, FSIZE_t offset) {
+    source->position = offset;
+}
+
+UINT sectorSourceRead(struct SectorSource *source, BYTE *buffer, UINT size) {
+    FSIZE_t left = source->end - source->position;
+    UINT read = left < size ? (UINT) left : size;
+    memcpy(buffer, source->data + source->position, read);
+    source->position += read;
+    FSIZE_t inBlock = (source->position - source->dataOffset) % source->blockAlign;
+    if (inBlock > 0 && inBlock < 4 && source->position < source->end) {
+        source->splitHeaders++;
+    }
+    return read;
+}
+
+bool sectorSourceEof(struct SectorSource *source) {
+    return source->position >= source->end;
+}
+
+/**
+ * @brief Read whole file.
+ * @param[in] path : Path of the file.
+ * @param[out] data : Buffer of @ref TEST_FILE_SIZE bytes.
+ * @return Number of read bytes, @p 0 on error.
+ */
+static size_t readFile(const char *path, uint8_t *data) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    size_t result = fread(data, 1, TEST_FILE_SIZE, file);
+    fclose(file);
+    return result;
+}
+
+/**
+ * @brief Read little endian number.
+ * @param[in] data : First byte.
+ * @param[in] size : Number of bytes, up to 4.
+ * @return Read number.
+ */
+static uint32_t readLittleEndian(const uint8_t *data, uint8_t size) {
+    uint32_t result = 0;
+    while (size--) {
+        result = result << 8 | data[size]; // NOLINT
+    }
+    return result;
+}
+
+/**
+ * @brief Find chunk of a RIFF file.
+ * @param[in] data : Whole file.
+ * @param[in] size : Size of the file.
+ * @param[in] id : Chunk type.
+ * @param[out] bodySize : Size of the chunk body.
+ * @return Offset of the chunk body, @p 0 if there is no such chunk.
+ */
+static size_t findChunk(const uint8_t *data, size_t size, const char *id, uint32_t *bodySize) {
+    size_t offset = 12;
+    while (offset + 8 <= size) {
+        *bodySize = readLittleEndian(data + offset + 4, 4);
+        if (memcmp(data + offset, id, 4) == 0) {
+            return offset + 8;
+        }
+        offset += 8 + *bodySize + (*bodySize & 1);
+    }
+    return 0;
+}
+
+/**
+ * @brief Decode the song through refills, played by the test instead of output interrupt, and compare samples.
+ */
+int main(int argc, char **argv) {
+    static uint8_t song[TEST_FILE_SIZE];
+    static uint8_t reference[TEST_FILE_SIZE];
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <song.wav> <reference.raw>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    size_t songSize = readFile(argv[1], song);
+    size_t referenceSize = readFile(argv[2], reference);
+    uint32_t formatSize;
+    uint32_t dataSize;
+    size_t format = findChunk(song, songSize, "fmt ", &formatSize);
+    size_t data = findChunk(song, songSize, "data", &dataSize);
+    if (referenceSize == 0 || format == 0 || data == 0 || data + dataSize > songSize) {
+        fprintf(stderr, "Can not read %s or %s\n", argv[1], argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    struct SampleDecoder decoder;
+    uint16_t blockAlign = (uint16_t) readLittleEndian(song + format + 12, 2);
+    uint32_t sampleRate = readLittleEndian(song + format + 4, 4);
+    if (readLittleEndian(song + format, 2) != TEST_FORMAT_IMA_ADPCM
+        || !sampleDecoderInit(&decoder, TEST_FORMAT_IMA_ADPCM, (uint16_t) readLittleEndian(song + format + 14, 2),
+                              (uint16_t) readLittleEndian(song + format + 2, 2), blockAlign)) {
+        fprintf(stderr, "%s is not a supported IMA ADPCM song\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    struct SectorSource source = {song, 0, data + dataSize, 0, blockAlign, data};
+    struct PlaybackBuffer *buffer = bufferInit(&decoder, sampleRate, sampleRate);
+    bufferSeek(buffer, &source, data);
+
+    size_t played = 0;
+    size_t mismatches = 0;
+    for (;;) {
+        sourceRefillBuffer(&source, buffer);
+        // Played half is given back, refilled one is played whole.
+        bufferNextHalf(buffer);
+        if (buffer->silent) {
+            break;
+        }
+        for (const uint8_t *sample = buffer->readPosition; sample != buffer->readEnd; sample++, played++) {
+            if (played >= referenceSize || *sample != reference[played]) {
+                if (mismatches++ < 10) {
+                    fprintf(stderr, "Sample %zu: %u, expected %d\n", played, *sample,
+                            played < referenceSize ? reference[played] : -1);
+                }
+            }
+        }
+        buffer->readPosition = buffer->readEnd;
+    }
+    bufferDestroy(buffer);
+
+    printf("samples %zu of %zu, mismatches %zu, block headers split between refills %lu\n", played, referenceSize,
+           mismatches, (unsigned long) source.splitHeaders);
+    if (played != referenceSize || mismatches != 0 || source.splitHeaders == 0) {
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
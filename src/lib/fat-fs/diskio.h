@@ -35,6 +35,28 @@ DRESULT disk_read (BYTE pdrv, BYTE* buff, DWORD sector, UINT count);
 DRESULT disk_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 
+/* Streaming read, keeps READ_MULTIPLE_BLOCK open until closed or any other command is issued */
+DRESULT disk_stream_open (BYTE pdrv, DWORD sector);
+DRESULT disk_stream_read (BYTE pdrv, BYTE* buff);
+DRESULT disk_stream_close (BYTE pdrv);
+
+#ifdef SD_STATISTICS
+/* I/O statistics, latencies are timed by the scheduler clock (timers.h) while it runs */
+#define DSTATS_BUCKETS	12	/* Bucket n>0 counts latencies of 2^(n-1) to 2^n-1 units of 64 cycles, the last one longer too */
+
+typedef struct {
+	BYTE	read[DSTATS_BUCKETS];	/* Latency histogram of disk_read */
+	BYTE	ready[DSTATS_BUCKETS];	/* Latency histogram of waiting for card ready */
+	BYTE	block[DSTATS_BUCKETS];	/* Latency histogram of receiving a data block, token wait included */
+	DWORD	bytes;					/* Data block bytes received */
+	DWORD	spins;					/* Busy-wait polls of ready state and data token */
+	WORD	commands;				/* Command packets sent */
+} DSTATS;	/* Histogram buckets are halved when one of them saturates, so they keep the shape */
+
+const DSTATS* disk_stats (BYTE pdrv);
+void disk_stats_reset (BYTE pdrv);
+#endif
+
 
 /* Disk Status Bits (DSTATUS) */
 #define STA_NOINIT		0x01	/* Drive not initialized */
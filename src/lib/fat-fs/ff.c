@@ -4509,6 +4509,29 @@ FRESULT f_readdir (
 
 
 
+
+/*-----------------------------------------------------------------------*/
+/* Seek Directory Object                                                 */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_seekdir (
+	DIR* dp,			/* Pointer to the open directory object */
+	DWORD ofs			/* Offset to read the next item from, a value of f_telldir() */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+
+
+	res = validate(&dp->obj, &fs);	/* Check validity of the directory object */
+	if (res == FR_OK) {
+		res = dir_sdi(dp, ofs);		/* Move the directory index, the table is searched forward from there */
+	}
+	LEAVE_FF(fs, res);
+}
+
+
+
 #if FF_USE_FIND
 /*-----------------------------------------------------------------------*/
 /* Find Next File                                                        */
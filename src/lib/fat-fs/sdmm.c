@@ -20,10 +20,15 @@
 
   * Low Speed
     The data transfer rate will be several times slower than hardware SPI.
+    Define SD_HARDWARE_SPI to use the SPI peripheral of the ATmega instead.
 
   * No Media Change Detection
     Application program needs to perform a f_mount() after media change.
 
+  * I/O Statistics
+    Define SD_STATISTICS to time disk_read, wait_ready and rcvr_datablock
+    by the scheduler clock and count bytes, commands and busy-wait polls.
+
 /-------------------------------------------------------------------------*/
 
 
@@ -40,6 +45,28 @@
 #define PIN_GROUP_REGISTER DDRA
 #define PIN_GROUP_PORT PORTA
 
+#ifdef SD_HARDWARE_SPI
+
+/* Hardware SPI: MISO PB6 (MMC DO), MOSI PB5 (MMC DI), SCK PB7, SS PB4 (MMC CS).
+/  The bus may be shared with other SPI devices. The card owns the bus only
+/  between select() and deselect(), and it restores its own clock on select(),
+/  so other devices may reprogram SPCR while the card is deselected. */
+
+#define SPI_REGISTER DDRB
+#define SPI_PORT PORTB
+
+#define SPI_INIT()	SPI_REGISTER |= _BV(PB4) | _BV(PB5) | _BV(PB7)	/* SS, MOSI and SCK as outputs */
+
+#define CS_INIT()	SPI_REGISTER |= _BV(PB4)	/* Initialize port for MMC CS as output */
+#define	CS_H()		SPI_PORT |= _BV(PB4)	/* Set MMC CS "high" */
+#define CS_L()		SPI_PORT &= ~_BV(PB4)	/* Set MMC CS "low" */
+
+#define FCLK_SLOW()	SpiControl = _BV(SPE) | _BV(MSTR) | _BV(SPR1), SpiDoubleSpeed = 0	/* F_CPU/64, 100-400kHz during init */
+#define FCLK_FAST()	SpiControl = _BV(SPE) | _BV(MSTR), SpiDoubleSpeed = _BV(SPI2X)	/* F_CPU/2 */
+#define FCLK_APPLY()	SPCR = SpiControl, SPSR = SpiDoubleSpeed	/* Take the bus with card's clock */
+
+#else
+
 #define DO_INIT()					/* Initialize port for MMC DO as input */
 #define DO			(PIN_GROUP_PIN &	0x01)	/* Test for MMC DO ('H':true, 'L':false) */
 
@@ -55,6 +82,12 @@
 #define	CS_H()		PIN_GROUP_PORT |= 0x08	/* Set MMC CS "high" */
 #define CS_L()		PIN_GROUP_PORT &= 0xF7	/* Set MMC CS "low" */
 
+#define FCLK_SLOW()	((void)0)	/* Bit-banging runs at a single speed */
+#define FCLK_FAST()	((void)0)
+#define FCLK_APPLY()	((void)0)
+
+#endif
+
 
 static
 void dly_us (UINT n)	/* Delay n microseconds (avr-gcc -Os) */
@@ -123,7 +156,123 @@ DSTATUS Stat = STA_NOINIT;	/* Disk status */
 static
 BYTE CardType;			/* b0:MMC, b1:SDv1, b2:SDv2, b3:Block addressing */
 
+static
+BYTE Streaming;			/* 1: READ_MULTIPLE_BLOCK is kept open between reads */
+
+static
+DWORD StreamSector;		/* Next sector delivered by the open stream (LBA) */
+
+#ifdef SD_HARDWARE_SPI
+static
+BYTE SpiControl, SpiDoubleSpeed;	/* SPCR and SPSR values used while the card is selected */
+#endif
+
+
+
+#ifdef SD_STATISTICS
+
+#include "../../hal/timers.h"
+
+static
+DSTATS Stats;			/* I/O statistics */
+
+/*-----------------------------------------------------------------------*/
+/* Add a latency to a histogram                                          */
+/*-----------------------------------------------------------------------*/
+
+static
+void stats_record (
+	BYTE *hist,			/* Histogram of DSTATS_BUCKETS buckets */
+	WORD start			/* Timestamp taken at the start */
+)
+{
+	WORD t;
+	BYTE n;
+
+
+	if (!timersTickIsRunning()) return;	/* Timestamps stand still */
+
+	t = timersTimestamp() - start;
+	for (n = 0; t && n < DSTATS_BUCKETS - 1; n++) t >>= 1;	/* Bucket of the highest set bit */
 
+	if (hist[n] == 0xFF) {		/* Halve the histogram instead of saturating */
+		BYTE i;
+		for (i = 0; i < DSTATS_BUCKETS; i++) hist[i] >>= 1;
+	}
+	hist[n]++;
+}
+
+#define	STATS_START()	WORD stats_start = timersTimestamp()
+#define	STATS_RECORD(h)	stats_record(Stats.h, stats_start)
+#define	STATS_ADD(c, n)	(Stats.c += (n))
+
+#else
+
+#define	STATS_START()
+#define	STATS_RECORD(h)	((void)0)
+#define	STATS_ADD(c, n)	((void)0)
+
+#endif
+
+
+
+#ifdef SD_HARDWARE_SPI
+
+/*-----------------------------------------------------------------------*/
+/* Exchange a byte with the card (hardware SPI)                          */
+/*-----------------------------------------------------------------------*/
+
+static
+BYTE xchg_spi (
+	BYTE d				/* Byte to be sent */
+)
+{
+	SPDR = d;
+	loop_until_bit_is_set(SPSR, SPIF);
+	return SPDR;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Transmit bytes to the card (hardware SPI)                             */
+/*-----------------------------------------------------------------------*/
+
+static
+void xmit_mmc (
+	const BYTE* buff,	/* Data to be sent */
+	UINT bc				/* Number of bytes to send */
+)
+{
+	do {
+		xchg_spi(*buff++);
+	} while (--bc);
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Receive bytes from the card (hardware SPI)                            */
+/*-----------------------------------------------------------------------*/
+
+static
+void rcvr_mmc (
+	BYTE *buff,	/* Pointer to read buffer */
+	UINT bc		/* Number of bytes to receive */
+)
+{
+	SPDR = 0xFF;						/* Start the first byte */
+	while (--bc) {
+		loop_until_bit_is_set(SPSR, SPIF);
+		BYTE r = SPDR;
+		SPDR = 0xFF;					/* Start the next byte before storing this one */
+		*buff++ = r;
+	}
+	loop_until_bit_is_set(SPSR, SPIF);
+	*buff = SPDR;
+}
+
+#else
 
 /*-----------------------------------------------------------------------*/
 /* Transmit bytes to the card (bitbanging)                               */
@@ -197,6 +346,8 @@ void rcvr_mmc (
 	} while (--bc);
 }
 
+#endif
+
 
 
 /*-----------------------------------------------------------------------*/
@@ -208,13 +359,16 @@ int wait_ready (void)	/* 1:OK, 0:Timeout */
 {
 	BYTE d;
 	UINT tmr;
+	STATS_START();
 
 
 	for (tmr = 5000; tmr; tmr--) {	/* Wait for ready in timeout of 500ms */
 		rcvr_mmc(&d, 1);
 		if (d == 0xFF) break;
+		STATS_ADD(spins, 1);
 		dly_us(100);
 	}
+	STATS_RECORD(ready);
 
 	return tmr ? 1 : 0;
 }
@@ -245,6 +399,7 @@ int select (void)	/* 1:OK, 0:Timeout */
 {
 	BYTE d;
 
+	FCLK_APPLY();		/* Take the bus with card's SPI clock */
 	CS_L();				/* Set CS# low */
 	rcvr_mmc(&d, 1);	/* Dummy clock (force DO enabled) */
 	if (wait_ready()) return 1;	/* Wait for card ready */
@@ -267,17 +422,24 @@ int rcvr_datablock (	/* 1:OK, 0:Failed */
 {
 	BYTE d[2];
 	UINT tmr;
+	STATS_START();
 
 
 	for (tmr = 1000; tmr; tmr--) {	/* Wait for data packet in timeout of 100ms */
 		rcvr_mmc(d, 1);
 		if (d[0] != 0xFF) break;
+		STATS_ADD(spins, 1);
 		dly_us(100);
 	}
-	if (d[0] != 0xFE) return 0;		/* If not valid data token, return with error */
+	if (d[0] != 0xFE) {				/* If not valid data token, return with error */
+		STATS_RECORD(block);
+		return 0;
+	}
 
 	rcvr_mmc(buff, btr);			/* Receive the data block into buffer */
 	rcvr_mmc(d, 2);					/* Discard CRC */
+	STATS_ADD(bytes, btr);
+	STATS_RECORD(block);
 
 	return 1;						/* Return with success */
 }
@@ -314,6 +476,25 @@ int xmit_datablock (	/* 1:OK, 0:Failed */
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Stop an open multiple block read                                      */
+/*-----------------------------------------------------------------------*/
+
+static
+BYTE send_cmd (BYTE cmd, DWORD arg);
+
+static
+void stream_stop (void)
+{
+	Streaming = 0;
+	FCLK_APPLY();
+	CS_L();
+	send_cmd(CMD12, 0);	/* STOP_TRANSMISSION */
+	deselect();
+}
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Send a command packet to the card                                     */
 /*-----------------------------------------------------------------------*/
@@ -327,6 +508,8 @@ BYTE send_cmd (		/* Returns command response (bit7==1:Send failed)*/
 	BYTE n, d, buf[6];
 
 
+	if (Streaming && cmd != CMD12) stream_stop();	/* Any other command ends an open stream */
+
 	if (cmd & 0x80) {	/* ACMD<n> is the command sequense of CMD55-CMD<n> */
 		cmd &= 0x7F;
 		n = send_cmd(CMD55, 0);
@@ -350,6 +533,7 @@ BYTE send_cmd (		/* Returns command response (bit7==1:Send failed)*/
 	if (cmd == CMD8) n = 0x87;		/* (valid CRC for CMD8(0x1AA)) */
 	buf[5] = n;
 	xmit_mmc(buf, 6);
+	STATS_ADD(commands, 1);
 
 	/* Receive command response */
 	if (cmd == CMD12) rcvr_mmc(&d, 1);	/* Skip a stuff byte when stop reading */
@@ -400,11 +584,17 @@ DSTATUS disk_initialize (
 
 	if (drv) return RES_NOTRDY;
 
+	Streaming = 0;			/* Card is reset, so is any open stream */
 	dly_us(10000);			/* 10ms */
 	CS_INIT(); CS_H();		/* Initialize port pin tied to CS */
+#ifdef SD_HARDWARE_SPI
+	SPI_INIT();				/* Initialize SPI pins */
+	FCLK_SLOW(); FCLK_APPLY();	/* Initialization must be done at 100-400kHz */
+#else
 	CK_INIT(); CK_L();		/* Initialize port pin tied to SCLK */
 	DI_INIT();				/* Initialize port pin tied to DI */
 	DO_INIT();				/* Initialize port pin tied to DO */
+#endif
 
 	for (n = 10; n; n--) rcvr_mmc(buf, 1);	/* Apply 80 dummy clocks and the card gets ready to receive command */
 
@@ -441,12 +631,87 @@ DSTATUS disk_initialize (
 	Stat = s;
 
 	deselect();
+	if (ty) FCLK_FAST();	/* Full speed from now on */
 
 	return s;
 }
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Open Streaming Read                                                   */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_stream_open (
+	BYTE drv,			/* Physical drive nmuber (0) */
+	DWORD sector		/* Start sector number (LBA) */
+)
+{
+	DRESULT res;
+
+
+	if (disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
+
+	res = RES_ERROR;
+	if (send_cmd(CMD18, (CardType & CT_BLOCK) ? sector : sector * 512) == 0) {	/* READ_MULTIPLE_BLOCK, stops any open stream */
+		Streaming = 1;
+		StreamSector = sector;
+		res = RES_OK;
+	}
+	deselect();			/* Release the bus, card holds data until it is clocked out */
+
+	return res;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Read Next Sector of the Stream                                        */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_stream_read (
+	BYTE drv,			/* Physical drive nmuber (0) */
+	BYTE *buff			/* Pointer to the 512 byte data buffer */
+)
+{
+	int ok;
+
+
+	if (disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
+	if (!Streaming) return RES_PARERR;
+
+	FCLK_APPLY();
+	CS_L();				/* No select(), waiting for ready would eat the data token */
+	ok = rcvr_datablock(buff, 512);
+	deselect();
+	if (!ok) {
+		stream_stop();
+		return RES_ERROR;
+	}
+	StreamSector++;
+
+	return RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Close Streaming Read                                                  */
+/*-----------------------------------------------------------------------*/
+
+DRESULT disk_stream_close (
+	BYTE drv			/* Physical drive nmuber (0) */
+)
+{
+	if (drv) return RES_PARERR;
+
+	if (Streaming) stream_stop();
+
+	return RES_OK;
+}
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Read Sector(s)                                                        */
 /*-----------------------------------------------------------------------*/
@@ -458,21 +723,19 @@ DRESULT disk_read (
 	UINT count			/* Sector count (1..128) */
 )
 {
-	BYTE cmd;
-
-
 	if (disk_status(drv) & STA_NOINIT) return RES_NOTRDY;
-	if (!(CardType & CT_BLOCK)) sector *= 512;	/* Convert LBA to byte address if needed */
 
-	cmd = count > 1 ? CMD18 : CMD17;			/*  READ_MULTIPLE_BLOCK : READ_SINGLE_BLOCK */
-	if (send_cmd(cmd, sector) == 0) {
+	STATS_START();
+
+	/* The stream is left open after the read, so reading the following
+	/  sectors next time costs neither a command nor a STOP_TRANSMISSION */
+	if ((Streaming && sector == StreamSector) || disk_stream_open(drv, sector) == RES_OK) {
 		do {
-			if (!rcvr_datablock(buff, 512)) break;
+			if (disk_stream_read(drv, buff) != RES_OK) break;
 			buff += 512;
 		} while (--count);
-		if (cmd == CMD18) send_cmd(CMD12, 0);	/* STOP_TRANSMISSION */
 	}
-	deselect();
+	STATS_RECORD(read);
 
 	return count ? RES_ERROR : RES_OK;
 }
@@ -531,6 +794,7 @@ DRESULT disk_ioctl (
 
 
 	if (disk_status(drv) & STA_NOINIT) return RES_NOTRDY;	/* Check if card is in the socket */
+	if (Streaming) stream_stop();	/* select() below would eat streamed data */
 
 	res = RES_ERROR;
 	switch (ctrl) {
@@ -567,3 +831,39 @@ DRESULT disk_ioctl (
 }
 
 
+
+#ifdef SD_STATISTICS
+
+/*-----------------------------------------------------------------------*/
+/* Get I/O Statistics                                                    */
+/*-----------------------------------------------------------------------*/
+
+const DSTATS* disk_stats (
+	BYTE drv			/* Physical drive nmuber (0) */
+)
+{
+	(void)drv;
+
+	return &Stats;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Clear I/O Statistics                                                  */
+/*-----------------------------------------------------------------------*/
+
+void disk_stats_reset (
+	BYTE drv			/* Physical drive nmuber (0) */
+)
+{
+	BYTE *p = (BYTE*)&Stats;
+	UINT n = sizeof Stats;
+
+
+	(void)drv;
+
+	do *p++ = 0; while (--n);
+}
+
+#endif
@@ -37,6 +37,7 @@
 int16_t  cursor_x, cursor_y;
 uint16_t textcolor, textbgcolor;
 uint8_t  wrap; // If set, 'wrap' text at right edge of display
+uint8_t  scroll_y, scroll_h; // Vertical scrolling area, in rows of drawing coordinates
 
 
 /*
@@ -72,6 +73,13 @@ inline void SPI_begin(void) {
 inline void SPI_end(void) {
 }
 
+// CS is tied to GND, the bus is not shared
+inline void SPI_select(void) {
+}
+
+inline void SPI_deselect(void) {
+}
+
 /*
 inline void spiwrite(uint8_t c) {
 	uint8_t i;
@@ -144,6 +152,7 @@ void spiwrite(uint8_t c) {
 /* SPI general support functions */
 
 inline void writecommand(uint8_t c) {
+	SPI_select();
 	RSPORT &= ~(1 << RS);
 	spiwrite(c);
 }
@@ -165,7 +174,7 @@ inline void spistreampixel(uint16_t color) {
 
 #ifdef SPI_HARDWARE
 
-inline void SPI_begin(void) {
+static inline void SPI_begin(void) {
 	
 	uint8_t tmp;
     SPIREG |= (1 << SCK);//out
@@ -174,8 +183,11 @@ inline void SPI_begin(void) {
     SPIPORT &= ~(1 << SCK);//lo
     SPIPORT &= ~(1 << MOSI);//lo
 
-    DDRB |= (1 << PB2);//out  SS
-    PORTB |= (1 << PB2);//hi  SS
+    SPIREG |= (1 << SS);//out  SS, keeps master mode
+    SPIPORT |= (1 << SS);//hi  SS
+
+    CSREG |= (1 << CS);//out
+    CSPORT |= (1 << CS);//hi - deselected until the first command
 		 
 	tmp=SPCR;		// Move SPCR to temp register to allow better optimization (saves 16 bytes!)
     tmp |= (1 << MSTR) | (1 << SPE);
@@ -187,28 +199,41 @@ inline void SPI_begin(void) {
 	SPSR |= 1<<SPI2X;		
 }
 
-inline void SPI_end(void) {
+static inline void SPI_end(void) {
     SPCR &= ~(1 << SPE);
 }
 
-inline void spiwrite(uint8_t c) {
+// Take the bus, SD card may have left its own clock in SPCR
+static inline void SPI_select(void) {
+	SPCR = (1 << SPE) | (1 << MSTR);	// Mode 0, MSB first
+	SPSR = (1 << SPI2X);				// F_CPU/2
+	CSPORT &= ~(1 << CS);
+}
+
+// Release the bus, following traffic is not for the display
+static inline void SPI_deselect(void) {
+	CSPORT |= (1 << CS);
+}
+
+static inline void spiwrite(uint8_t c) {
     SPDR = c;
     while (!(SPSR & (1 << SPIF))) ;
 }
 
 /* SPI general support functions */
 
-inline void writecommand(uint8_t c) {
+static inline void writecommand(uint8_t c) {
+    SPI_select();
     RSPORT &= ~(1 << RS);
     spiwrite(c);
 }
 
-inline void writedata(uint8_t c) {
+static inline void writedata(uint8_t c) {
     RSPORT |= (1 << RS);
     spiwrite(c);
 }
 
-inline void spistreampixel(uint16_t color) {
+static inline void spistreampixel(uint16_t color) {
 	spiwrite(color>>8);
 	spiwrite(color&0xff);
 }
@@ -305,6 +330,7 @@ void commandList(const uint8_t *addr) {
             myDelay(ms);
         }
     }
+    SPI_deselect();
 }
 
 void init(void) {
@@ -347,6 +373,24 @@ void setAddrWindow(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
 }
 
 
+// Burst pixel writes: a single address window, filled row by row by streamed pixels.
+// Anything but streamPixels() in between ends the burst.
+void beginPixels(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1) {
+    setAddrWindow(x0, y0, x1, y1);
+    RSPORT |= (1 << RS);
+}
+
+void streamPixels(uint16_t color, uint16_t n) {
+    while (n--) {
+		spistreampixel(color);
+    }
+}
+
+void endPixels(void) {
+    SPI_deselect();
+}
+
+
 void fillScreen(uint16_t color) {
 	fillRect(0, 0, _width, _height,color);
 }
@@ -355,10 +399,9 @@ void fillScreen(uint16_t color) {
 void drawPixel(int16_t x, int16_t y, uint16_t color) {
     if((x < 0) ||(x >= _width) || (y < 0) || (y >= _height)) return;
 
-    setAddrWindow(x,y,x+1,y+1);
-
-    RSPORT |= (1 << RS);
+    beginPixels(x,y,x+1,y+1);
 	spistreampixel(color);
+    endPixels();
 }
 
 
@@ -366,13 +409,9 @@ void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
     // Rudimentary clipping
     if((x >= _width) || (y >= _height)) return;
     if((y+h-1) >= _height) h = _height-y;
-    setAddrWindow(x, y, x, y+h-1);
-
-    RSPORT |= (1 << RS);
-
-    while (h--) {
-		spistreampixel(color);
-    }
+    beginPixels(x, y, x, y+h-1);
+    streamPixels(color, h);
+    endPixels();
 }
 
 void drawFastHLine(int16_t x, int16_t y, int16_t w,
@@ -381,13 +420,9 @@ void drawFastHLine(int16_t x, int16_t y, int16_t w,
     // Rudimentary clipping
     if((x >= _width) || (y >= _height)) return;
     if((x+w-1) >= _width)  w = _width-x;
-    setAddrWindow(x, y, x+w-1, y);
- 
-    RSPORT |= (1 << RS);
-
-    while (w--) {
-		spistreampixel(color);
-    }
+    beginPixels(x, y, x+w-1, y);
+    streamPixels(color, w);
+    endPixels();
 }
 
 // draw a rectangle
@@ -407,19 +442,14 @@ void fillRect(int16_t x, int16_t y, int16_t w, int16_t h,uint16_t color) {
     if((x + w - 1) >= _width)  w = _width  - x;
     if((y + h - 1) >= _height) h = _height - y;
 
-    setAddrWindow(x, y, x+w-1, y+h-1);
-
-    RSPORT |= (1 << RS);
-
-    for(y=h; y>0; y--) {
-        for(x=w; x>0; x--) {
-			spistreampixel(color);
-        }
-    }
+    beginPixels(x, y, x+w-1, y+h-1);
+    streamPixels(color, (uint16_t)w * h);
+    endPixels();
 }
 
 void invertDisplay(unsigned char i) {
     writecommand(i ? ST7735_INVON : ST7735_INVOFF);
+    SPI_deselect();
 }
 
 #define swap(a, b) { int16_t t = a; a = b; b = t; }
@@ -481,46 +511,96 @@ void write(uint8_t c) {
 	}
 }
 
+// Characters of a text row are drawn together by drawString(), breaking
+// runs where write() would move the cursor to the next row.
 void print(const char str[]) {
-	int x=0;
-	while(str[x]) {
-		write(str[x]);
-		x++;
+	while(*str) {
+		if (*str == '\n' || *str == '\r') {
+			write(*str++);
+			continue;
+		}
+
+		uint8_t n = 0;
+		int16_t fit = (_width - cursor_x) / 6;
+		if (fit < 1) fit = 1;	// write() draws at least one character before wrapping
+		while (str[n] && str[n] != '\n' && str[n] != '\r' && (!wrap || n < fit) && n < UCHAR_MAX) {
+			n++;
+		}
+
+		drawString(cursor_x, cursor_y, str, n, textcolor, textbgcolor);
+		cursor_x += 6 * n;
+		if (wrap && (cursor_x > (_width - 6))) {
+			cursor_y += 8;
+			cursor_x = 0;
+		}
+		str += n;
 	}
 }
 
 // draw a character
 void drawChar(int16_t x, int16_t y, unsigned char c,
+uint16_t color, uint16_t bg) {
+	drawString(x, y, (const char *)&c, 1, color, bg);
+}
+
+// draw characters of a text row through a single address window,
+// streaming its pixel rows across all of them
+void drawString(int16_t x, int16_t y, const char str[], uint8_t n,
 uint16_t color, uint16_t bg) {
 
 	if((x >= _width)   || // Clip right
 	(y >= _height)     || // Clip bottom
-	((x + 5 - 1) < 0)  || // Clip left
+	(x < 0)            || // Clip left
 	((y + 8 - 1) < 0))    // Clip top
 	return;
 
-	c=c-32;
-	for (int8_t i=0; i<6; i++ ) {
-		uint8_t line;
-		if ((i == 5) || (c>(128-32)))   // All invalid characters will print as a space
-			line = 0x0;
-		else
-			line = pgm_read_byte(font+(c*5)+i);
-
-	    setAddrWindow(x+i, y, x+i, y+7);
-	    RSPORT |= (1 << RS);
-
-		for (int8_t j = 0; j<8; j++) {
-			if (line & 0x1) {
-				    spiwrite(color>>8);
-					spiwrite(color&0xff);
-				} else {
-				    spiwrite(bg>>8);
-				    spiwrite(bg&0xff);
+	if (n > (_width - x) / 6) n = (_width - x) / 6;	// Whole characters only
+	if (!n) return;
+
+	beginPixels(x, y, x+6*n-1, y+7);
+
+	for (uint8_t mask = 0x1; mask; mask <<= 1) {
+		for (uint8_t k = 0; k < n; k++) {
+			uint8_t c = str[k]-32;
+			const unsigned char *glyph = font+(c*5);
+			for (int8_t i=0; i<6; i++ ) {
+				uint8_t line;
+				if ((i == 5) || (c>(128-32)))   // All invalid characters will print as a space
+					line = 0x0;
+				else
+					line = pgm_read_byte(glyph+i);
+
+				spistreampixel(line & mask ? color : bg);
 			}
-			line >>= 1; 
 		}
 	}
+
+	endPixels();
+}
+
+// Define vertical scrolling area: rows y to y+h-1 scroll, rows above and below stay fixed.
+// MADCTL MY flips rows, so the panel counts the areas from the bottom of the frame memory.
+void setScrollArea(uint8_t y, uint8_t h) {
+	scroll_y = y;
+	scroll_h = h;
+
+	writecommand(ST7735_VSCRDEF);
+	writedata(0x00);
+	writedata(ST7735_MEMHEIGHT - y - h);	// Top fixed area, below the scrolling one in drawing coordinates
+	writedata(0x00);
+	writedata(h);							// Vertical scrolling area
+	writedata(0x00);
+	writedata(y);							// Bottom fixed area, above the scrolling one in drawing coordinates
+
+	scrollTo(0);		// Releases the bus
+}
+
+// Show row y+offset of the scrolling area at its top, rows below it wrap around within the area.
+void scrollTo(uint8_t offset) {
+	writecommand(ST7735_VSCRSADD);
+	writedata(0x00);
+	writedata(ST7735_MEMHEIGHT - scroll_y - scroll_h + (offset ? scroll_h - offset : 0));
+	SPI_deselect();
 }
 
 void setCursor(int16_t x, int16_t y) {
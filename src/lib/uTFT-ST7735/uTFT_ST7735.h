@@ -38,17 +38,50 @@
  * CS       GND
  */
 //
+#ifndef LCD_HARDWARE_SPI
  #define SPI_SOFTWARE
  #define RSREG DDRB
  #define RSTREG DDRB
  #define RSPORT PORTB
  #define RSTPORT PORTB
  #define RS PB1
+#ifdef SD_HARDWARE_SPI
+ #define RST PB3 // PB5 is MOSI of the SD card hardware SPI
+#else
  #define RST PB5
+#endif
  #define SPIREG DDRB
  #define SPIPORT PORTB
  #define SCK PB2
  #define MOSI PB0
+#endif
+
+/*
+	// ATmega32 with hardware SPI, shared with the SD card when it uses hardware SPI too
+
+ * SCL      PB7 (SCK)
+ * SDA      PB5 (MOSI)
+ * RS       PB1
+ * RST      PB3
+ * CS       PB0, the display has to ignore the card's traffic
+ */
+#ifdef LCD_HARDWARE_SPI
+ #define SPI_HARDWARE
+ #define RSREG DDRB
+ #define RSTREG DDRB
+ #define RSPORT PORTB
+ #define RSTPORT PORTB
+ #define RS PB1
+ #define RST PB3
+ #define SPIREG DDRB
+ #define SPIPORT PORTB
+ #define SCK PB7
+ #define MOSI PB5
+ #define SS PB4 // has to be an output in master mode, MMC CS with SD card hardware SPI
+ #define CSREG DDRB
+ #define CSPORT PORTB
+ #define CS PB0
+#endif
 
 #define _width    128
 #define _height   160
@@ -67,10 +100,18 @@ void invertDisplay(unsigned char i);
 void drawChar(int16_t x, int16_t y, unsigned char c,uint16_t color, uint16_t bg);
 void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
 void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+void drawString(int16_t x, int16_t y, const char str[], uint8_t n, uint16_t color, uint16_t bg);
+
+void beginPixels(uint8_t x0, uint8_t y0, uint8_t x1, uint8_t y1);
+void streamPixels(uint16_t color, uint16_t n);
+void endPixels(void);
 
 void print(const char str[]);
 void write(uint8_t);
 
+void setScrollArea(uint8_t y, uint8_t h);
+void scrollTo(uint8_t offset);
+
 void setCursor(int16_t x, int16_t y);
 void setTextColor(uint16_t c, uint16_t bg);
 void setTextWrap(uint8_t w);
@@ -110,6 +151,7 @@ void setTextWrap(uint8_t w);
 
 #define ST7735_TFTWIDTH  128
 #define ST7735_TFTHEIGHT 160
+#define ST7735_MEMHEIGHT 162 // rows of frame memory, vertical scroll areas add up to it
 
 #define ST7735_NOP     0x00
 #define ST7735_SWRESET 0x01
@@ -131,6 +173,8 @@ void setTextWrap(uint8_t w);
 #define ST7735_RAMRD   0x2E
 
 #define ST7735_PTLAR   0x30
+#define ST7735_VSCRDEF 0x33
+#define ST7735_VSCRSADD 0x37
 #define ST7735_COLMOD  0x3A
 #define ST7735_MADCTL  0x36
 
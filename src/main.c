@@ -7,17 +7,47 @@
  */
 
 #include <stdio.h>
-#include <avr/pgmspace.h>
 #include "view/view.h"
 #include "controller/controller.h"
+#include "player/audio_output.h"
+#include "player/wav_player.h"
+#include "scheduler/scheduler.h"
+#include "hal/ports.h"
+#include "hal/uart.h"
+#include "memory/ram_budget.h"
 #include "lib/fat-fs/ff.h"
+#include "lib/fat-fs/diskio.h"
+
+#ifdef SD_STATISTICS
+/**
+ * @brief I/O statistics of the disk layer, too big to be left to the stack reserve.
+ */
+#define DISK_STATS_SIZE sizeof(DSTATS)
+#else
+//! @cond Doxygen_Suppress
+#define DISK_STATS_SIZE 0
+//! @endcond
+#endif /* SD_STATISTICS */
+
+/**
+ * @brief Worst case of statically allocated RAM: objects of all modules and filesystem with its window.
+ */
+#define RAM_STATIC_SIZE (sizeof(FATFS) + WAV_PLAYER_TOTAL_RAM_BUDGET + VIEW_RAM_BUDGET + CONTROLLER_RAM_BUDGET \
+    + SCHEDULER_RAM_BUDGET + DISK_STATS_SIZE)
+
+#ifdef __AVR__
+RAM_BUDGET_CHECK(RAM_STATIC_SIZE + RAM_STACK_RESERVE, RAM_SIZE);
+#endif
 
 /**
  * @brief Initialize device, start active waiting by controller.
  */
 int main() {
-    DDRB = 0xff; // All B pins to output mode.
-    DDRD = 0xff; // All D pins (DAC) to output mode.
+    portsInit();
+    audioOutputInit();
+#if defined(SD_STATISTICS) && defined(UART_AVAILABLE)
+    uartInit();
+#endif
 
     FATFS FatFs;
     f_mount(&FatFs, "", 0);
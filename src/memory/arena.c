@@ -0,0 +1,31 @@
+/**
+ * @file
+ * Bump allocator implementation.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <string.h>
+#include "arena.h"
+
+void arenaInit(struct Arena *arena, void *memory, uint16_t size) {
+    arena->memory = memory;
+    arena->size = size;
+    arena->used = 0;
+}
+
+void *arenaAllocate(struct Arena *arena, uint16_t size) {
+    uint16_t aligned = (uint16_t) ARENA_ALIGN(size);
+    if (aligned > arena->size - arena->used) {
+        return NULL;
+    }
+    uint8_t *result = arena->memory + arena->used;
+    arena->used += aligned;
+    memset(result, 0, size);
+    return result;
+}
+
+inline void arenaReset(struct Arena *arena) {
+    arena->used = 0;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file
+ * Bump allocator interface, releasing all its objects at once.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Alignment of every allocation, a single byte on AVR.
+ */
+#define ARENA_ALIGNMENT _Alignof(max_align_t)
+
+/**
+ * @brief Number of arena bytes taken by an allocation of @p size bytes.
+ * @param[in] size : Allocated size.
+ */
+#define ARENA_ALIGN(size) (((size) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+
+/**
+ * @brief Allocator over a fixed memory block, objects are released together by @ref arenaReset.
+ * Exposed only because arenas are embedded in statically allocated objects.
+ */
+struct Arena {
+    uint8_t *memory; ///< Memory block, aligned to @ref ARENA_ALIGNMENT.
+    uint16_t size; ///< Size of @ref memory in bytes.
+    uint16_t used; ///< Number of allocated bytes.
+};
+
+/**
+ * @brief Initialize arena over a memory block.
+ * @param[out] arena : Arena to initialize.
+ * @param[in] memory : Memory block, aligned to @ref ARENA_ALIGNMENT.
+ * @param[in] size : Size of @p memory in bytes.
+ */
+void arenaInit(struct Arena *arena, void *memory, uint16_t size);
+
+/**
+ * @brief Allocate memory, it is zeroed like calloc does.
+ * @param[out] arena : Arena to allocate from.
+ * @param[in] size : Number of bytes.
+ * @return Pointer to allocated memory, @p NULL if arena is exhausted.
+ */
+void *arenaAllocate(struct Arena *arena, uint16_t size);
+
+/**
+ * @brief Release all memory allocated from arena.
+ * @param[out] arena : Arena to reset.
+ */
+void arenaReset(struct Arena *arena);
+
+#endif /* __ARENA_H__ */
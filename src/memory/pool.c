@@ -0,0 +1,30 @@
+/**
+ * @file
+ * Static object pool implementation.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "pool.h"
+
+void *poolTake(struct Pool *pool) {
+    for (uint8_t i = 0; i < pool->capacity; i++) {
+        if (!(pool->used & 1 << i)) { // NOLINT
+            pool->used |= 1 << i; // NOLINT
+            uint8_t *result = pool->objects + (uint16_t) i * pool->objectSize;
+            memset(result, 0, pool->objectSize);
+            return result;
+        }
+    }
+    return NULL;
+}
+
+void poolGive(struct Pool *pool, void *object) {
+    if (object != NULL) {
+        uint8_t index = (uint8_t) ((uint16_t) ((uint8_t *) object - pool->objects) / pool->objectSize);
+        pool->used &= ~(1 << index); // NOLINT
+    }
+}
@@ -0,0 +1,51 @@
+/**
+ * @file
+ * Static object pool interface.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __POOL_H__
+#define __POOL_H__
+
+#include <stdint.h>
+
+/**
+ * @brief Maximum number of objects in a single pool, one bit of @ref Pool.used each.
+ */
+#define POOL_MAX_CAPACITY 8
+
+/**
+ * @brief Initializer of a pool over a statically allocated array of objects.
+ * @param[in] objects : Array of at most @ref POOL_MAX_CAPACITY objects.
+ */
+#define POOL_INITIALIZER(objects) \
+    {(uint8_t *) (objects), sizeof((objects)[0]), sizeof(objects) / sizeof((objects)[0]), 0}
+
+/**
+ * @brief Fixed number of equally sized objects, taken and given back in constant time without heap.
+ * Exposed only because pools are statically initialized by @ref POOL_INITIALIZER.
+ */
+struct Pool {
+    uint8_t *objects; ///< Storage of all objects.
+    uint16_t objectSize; ///< Size of a single object in bytes.
+    uint8_t capacity; ///< Number of objects.
+    uint8_t used; ///< Bit mask of taken objects.
+};
+
+/**
+ * @brief Take a free object, it is zeroed like calloc does.
+ * @param[out] pool : Pointer to pool.
+ * @return Pointer to the object, @p NULL if all objects are taken.
+ */
+void *poolTake(struct Pool *pool);
+
+/**
+ * @brief Give an object back to its pool.
+ * @param[out] pool : Pointer to pool.
+ * @param[out] object : Object taken from @p pool, or @p NULL.
+ */
+void poolGive(struct Pool *pool, void *object);
+
+#endif /* __POOL_H__ */
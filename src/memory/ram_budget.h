@@ -0,0 +1,44 @@
+/**
+ * @file
+ * Compile-time accounting of statically allocated RAM.
+ * Every module keeps its objects in static pools, sized by a budget declared in its header.
+ * Budgets are checked against actual object sizes in module sources, and their sum against RAM in main.c.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __RAM_BUDGET_H__
+#define __RAM_BUDGET_H__
+
+#ifdef __AVR__
+/**
+ * @brief Budgets are given in bytes of AVR objects.
+ */
+#define RAM_BUDGET_SCALE 1
+#else
+/**
+ * @brief Pointers are up to four times wider on other targets, so are budgets of structures holding them.
+ */
+#define RAM_BUDGET_SCALE 4
+#endif
+
+/**
+ * @brief Size of RAM, 2KB on ATmega32.
+ */
+#define RAM_SIZE (RAMEND - RAMSTART + 1)
+
+/**
+ * @brief RAM left out of budgets: stack with interrupt frames, which FatFs directory listing takes most of,
+ * and small static variables of modules and libraries.
+ */
+#define RAM_STACK_RESERVE 384
+
+/**
+ * @brief Check at compile time, that objects fit in their budget.
+ * @param[in] size : Size of statically allocated objects.
+ * @param[in] budget : Budget declared for them.
+ */
+#define RAM_BUDGET_CHECK(size, budget) _Static_assert((size) <= (budget), #size " exceeds " #budget)
+
+#endif /* __RAM_BUDGET_H__ */
@@ -0,0 +1,108 @@
+/**
+ * @file
+ * Audio output backends, selected at build time: R2R resistor ladder on PORTD (default)
+ * or Timer2 fast PWM on OC2 (PD7), when AUDIO_OUTPUT_PWM is defined.
+ * Host build writes samples to a virtual DAC instead, see src/host.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __AUDIO_OUTPUT_H__
+#define __AUDIO_OUTPUT_H__
+
+#include "../hal/platform.h"
+
+/**
+ * @brief Output value of silence, middle of unsigned 8 bit range.
+ */
+#define AUDIO_OUTPUT_SILENCE ((uint8_t) 0x80)
+
+#ifdef HAL_HOST
+
+/**
+ * @brief Name of the backend, shown by the benchmark.
+ */
+#define AUDIO_OUTPUT_NAME "Virtual DAC"
+
+/**
+ * @brief Record a sample played by the virtual DAC, defined by host build.
+ * @param[in] sample : Unsigned 8 bit sample.
+ */
+void hostDacWrite(uint8_t sample);
+
+/**
+ * @brief Initialize output, virtual DAC is opened by host main.
+ */
+static inline void audioOutputInit() {
+}
+
+/**
+ * @brief Write sample to the virtual DAC.
+ * @param[in] sample : Unsigned 8 bit sample.
+ */
+static inline void audioOutputWrite(uint8_t sample) {
+    hostDacWrite(sample);
+}
+
+#elif defined(AUDIO_OUTPUT_PWM)
+
+/**
+ * @brief Name of the backend, shown by the benchmark.
+ */
+#define AUDIO_OUTPUT_NAME "PWM OC2"
+
+/**
+ * @brief Register written with samples, used by the naked output interrupt.
+ */
+#define AUDIO_OUTPUT_REGISTER OCR2
+
+/**
+ * @brief Initialize output: Timer2 fast PWM without prescaler, 31.25 kHz carrier at 8 MHz.
+ * Only PD7 is used, rest of PORTD is free.
+ */
+static inline void audioOutputInit() {
+    DDRD |= 1 << PD7; // NOLINT
+    OCR2 = AUDIO_OUTPUT_SILENCE;
+    TCCR2 = 1 << WGM20 | 1 << WGM21 | 1 << COM21 | 1 << CS20; // NOLINT
+}
+
+/**
+ * @brief Write sample, duty cycle is latched at the end of the current carrier period.
+ * @param[in] sample : Unsigned 8 bit sample.
+ */
+static inline void audioOutputWrite(uint8_t sample) {
+    AUDIO_OUTPUT_REGISTER = sample;
+}
+
+#else
+
+/**
+ * @brief Name of the backend, shown by the benchmark.
+ */
+#define AUDIO_OUTPUT_NAME "R2R PORTD"
+
+/**
+ * @brief Register written with samples, used by the naked output interrupt.
+ */
+#define AUDIO_OUTPUT_REGISTER PORTD
+
+/**
+ * @brief Initialize output: all PORTD pins drive the resistor ladder.
+ */
+static inline void audioOutputInit() {
+    DDRD = 0xff;
+    PORTD = AUDIO_OUTPUT_SILENCE;
+}
+
+/**
+ * @brief Write sample to the resistor ladder.
+ * @param[in] sample : Unsigned 8 bit sample.
+ */
+static inline void audioOutputWrite(uint8_t sample) {
+    AUDIO_OUTPUT_REGISTER = sample;
+}
+
+#endif /* HAL_HOST */
+
+#endif /* __AUDIO_OUTPUT_H__ */
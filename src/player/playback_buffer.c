@@ -0,0 +1,276 @@
+/**
+ * @file
+ * Ping-pong playback buffer implementation.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#include "playback_buffer.h"
+#include "../memory/pool.h"
+
+/**
+ * @brief Storage of the only playback buffer, there is nothing to play simultaneously.
+ */
+static struct PlaybackBuffer bufferObjects[1];
+
+/**
+ * @brief Pool of @ref bufferObjects.
+ */
+static struct Pool buffers = POOL_INITIALIZER(bufferObjects);
+
+/**
+ * @brief Single sample played, while buffer is starving.
+ */
+static uint8_t silence[1] = {PLAYBACK_BUFFER_SILENCE};
+
+/**
+ * @brief Drop all buffered samples, make output play silence until next refill.
+ * @param[out] buffer : Pointer to buffer.
+ */
+static void bufferStarve(struct PlaybackBuffer *buffer) {
+    for (uint8_t i = 0; i < PLAYBACK_BUFFER_HALVES; i++) {
+        buffer->halves[i].ready = false;
+    }
+    buffer->silent = true;
+    buffer->endOfStream = false;
+    buffer->readPosition = silence;
+    buffer->readEnd = silence + 1;
+}
+
+struct PlaybackBuffer *bufferInit(const struct SampleDecoder *decoder, uint32_t sampleRate, uint32_t outputRate) {
+    struct PlaybackBuffer *result = poolTake(&buffers);
+    if (result == NULL) {
+        return NULL;
+    }
+    result->decoder = *decoder;
+    resamplerInit(&result->resampler, sampleRate, outputRate);
+    result->stats.minimumFill = UINT16_MAX;
+    // First refilled half is the one after the playing one.
+    result->playingHalf = PLAYBACK_BUFFER_HALVES - 1;
+    bufferStarve(result);
+    return result;
+}
+
+inline void bufferDestroy(struct PlaybackBuffer *buffer) {
+    poolGive(&buffers, buffer);
+}
+
+/**
+ * @brief Make next refill start at @p offset, with fresh decoder and resampler state.
+ * Output interrupt has to be disabled, buffered halves are left as they are.
+ * @param[out] buffer : Pointer to buffer.
+ * @param[in] offset : File offset of the first frame to refill.
+ */
+static void bufferRestart(struct PlaybackBuffer *buffer, FSIZE_t offset) {
+    buffer->skip = (uint16_t) (offset % buffer->decoder.readSize);
+    buffer->nextOffset = offset - buffer->skip;
+    // Offset is a frame boundary, bytes of a frame before it are skipped anyway.
+    buffer->phase = (uint8_t) (buffer->skip % buffer->decoder.frameSize);
+    buffer->carryLength = 0;
+    sampleDecoderReset(&buffer->decoder);
+    resamplerReset(&buffer->resampler);
+}
+
+void bufferSeek(struct PlaybackBuffer *buffer, struct SectorSource *source, FSIZE_t offset) {
+    sectorSourceSeek(source, offset - offset % buffer->decoder.readSize);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        bufferRestart(buffer, offset);
+        bufferStarve(buffer);
+    }
+}
+
+void bufferSplice(struct PlaybackBuffer *buffer, struct SectorSource *source, const struct SampleDecoder *decoder,
+                  uint32_t sampleRate, uint32_t outputRate, FSIZE_t offset) {
+    sectorSourceSeek(source, offset - offset % decoder->readSize);
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        buffer->decoder = *decoder;
+        resamplerInit(&buffer->resampler, sampleRate, outputRate);
+        bufferRestart(buffer, offset);
+        // Queued halves of the previous song keep playing, refills continue right after them.
+        buffer->endOfStream = false;
+        // Position is reported in the next song already, its file offsets mean nothing for the previous one.
+        for (uint8_t i = 0; i < PLAYBACK_BUFFER_HALVES; i++) {
+            buffer->halves[i].offset = offset;
+        }
+    }
+}
+
+/**
+ * @brief Update refill telemetry.
+ * @param[out] buffer : Pointer to buffer, its counters are updated.
+ * @param[in] sizeBefore : Number of buffered samples before refill.
+ * @param[in] added : Number of samples added by refill.
+ * @param[in] sizeAfter : Number of buffered samples after refill.
+ */
+static void bufferRecordRefill(struct PlaybackBuffer *buffer, uint16_t sizeBefore, uint16_t added,
+                               uint16_t sizeAfter) {
+    struct PlaybackStats *stats = &buffer->stats;
+    // Samples played meanwhile, exact unless output starved during refill.
+    uint16_t duration = sizeBefore + added - sizeAfter;
+
+    stats->refills++;
+    if (sizeBefore < stats->minimumFill) {
+        stats->minimumFill = sizeBefore;
+    }
+    if (sizeBefore < bufferNearMissSamples(buffer)) {
+        stats->nearMisses++;
+    }
+    if (duration > stats->worstRefillDuration) {
+        stats->worstRefillDuration = duration;
+    }
+}
+
+void sourceRefillBuffer(struct SectorSource *source, struct PlaybackBuffer *buffer) {
+    struct PlaybackBufferHalf *half = &buffer->halves[buffer->playingHalf ^ 1];
+    if (half->ready || buffer->endOfStream) {
+        return;
+    }
+    // Buffer is primed after start and seek, and after an underrun, which is counted already, while output is silent.
+    bool measured = !buffer->silent;
+    uint16_t sizeBefore = bufferCurrentSize(buffer);
+
+    // Raw data is read to the end of the half, so samples expanding while decoded never overtake it.
+    struct SampleDecoder *decoder = &buffer->decoder;
+    uint8_t frameSize = decoder->frameSize;
+    uint8_t phase = buffer->phase;
+    uint8_t *raw = half->data + PLAYBACK_BUFFER_HALF_SIZE - decoder->readSize;
+    FSIZE_t readOffset = buffer->nextOffset;
+    UINT read = sectorSourceRead(source, raw, decoder->readSize);
+    bool endOfStream = sectorSourceEof(source);
+    buffer->nextOffset += read;
+    if (read <= buffer->skip || read < phase) {
+        buffer->endOfStream = endOfStream;
+        return;
+    }
+
+    // After seek skip is a frame boundary, so it is the phase followed by whole frames.
+    uint16_t start = buffer->skip > phase ? buffer->skip : phase;
+    uint8_t *begin = half->data + start;
+    FSIZE_t offset = readOffset + start;
+    if (buffer->carryLength != 0) {
+        // Complete the frame split between reads, its sample goes right before the first one.
+        memcpy(buffer->carry + buffer->carryLength, raw, phase);
+        decoder->decode(decoder, buffer->carry, buffer->carry, frameSize);
+        *--begin = buffer->carry[0];
+        offset -= frameSize;
+    }
+    uint16_t whole = (uint16_t) (read - start);
+    buffer->carryLength = (uint8_t) (whole % frameSize);
+    whole -= buffer->carryLength;
+    memcpy(buffer->carry, raw + start + whole, buffer->carryLength);
+    buffer->phase = buffer->carryLength != 0 ? frameSize - buffer->carryLength : 0;
+
+    uint8_t *end = half->data + start;
+    end += decoder->decode(decoder, end, raw + start, whole);
+    if (!resamplerIsUnity(&buffer->resampler)) {
+        end = begin + resamplerProcess(&buffer->resampler, begin, (uint16_t) (end - begin));
+    }
+    buffer->skip = 0;
+    if (begin == end) {
+        buffer->endOfStream = endOfStream;
+        return;
+    }
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        half->offset = offset;
+        half->begin = begin;
+        half->end = end;
+        half->ready = true;
+        buffer->endOfStream = endOfStream;
+    }
+    if (measured) {
+        bufferRecordRefill(buffer, sizeBefore, (uint16_t) (end - begin), bufferCurrentSize(buffer));
+    }
+}
+
+void bufferNextHalf(struct PlaybackBuffer *buffer) {
+    if (!buffer->silent) {
+        buffer->halves[buffer->playingHalf].ready = false;
+    }
+
+    uint8_t next = buffer->playingHalf ^ 1;
+    struct PlaybackBufferHalf *half = &buffer->halves[next];
+    if (!half->ready) {
+        if (!buffer->silent && !buffer->endOfStream) {
+            buffer->stats.underruns++;
+        }
+        buffer->silent = true;
+        buffer->readPosition = silence;
+        buffer->readEnd = silence + 1;
+        return;
+    }
+
+    buffer->silent = false;
+    buffer->playingHalf = next;
+    buffer->readPosition = half->begin;
+    buffer->readEnd = half->end;
+}
+
+uint16_t bufferPlayingSize(struct PlaybackBuffer *buffer) {
+    uint16_t result;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        result = buffer->silent ? 0 : (uint16_t) (buffer->readEnd - buffer->readPosition);
+    }
+    return result;
+}
+
+uint16_t bufferCurrentSize(struct PlaybackBuffer *buffer) {
+    uint16_t result;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        result = buffer->silent ? 0 : (uint16_t) (buffer->readEnd - buffer->readPosition);
+        struct PlaybackBufferHalf *next = &buffer->halves[buffer->playingHalf ^ 1];
+        if (next->ready) {
+            result += (uint16_t) (next->end - next->begin);
+        }
+    }
+    return result;
+}
+
+uint16_t bufferNearMissSamples(struct PlaybackBuffer *buffer) {
+    // Raw bytes of a full read, over raw bytes per sample and decoded samples per output one, both Q8.8.
+    uint32_t samples = ((uint32_t) buffer->decoder.readSize << 16) // NOLINT
+                       / ((uint32_t) buffer->decoder.bytesPerSample * buffer->resampler.step);
+    return (uint16_t) (samples >> PLAYBACK_BUFFER_NEAR_MISS_SHIFT); // NOLINT
+}
+
+FSIZE_t bufferPosition(struct PlaybackBuffer *buffer) {
+    FSIZE_t result;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+        struct PlaybackBufferHalf *half = &buffer->halves[buffer->playingHalf];
+        if (buffer->silent) {
+            half = &buffer->halves[buffer->playingHalf ^ 1];
+            result = half->ready ? half->offset : buffer->nextOffset + buffer->skip;
+        }
+        else {
+            // Every played sample advances raw data by the resampler step of decoded samples.
+            uint32_t played = ((uint32_t) (buffer->readPosition - half->begin) * buffer->resampler.step) >> 8; // NOLINT
+            result = half->offset + ((played * buffer->decoder.bytesPerSample) >> 8); // NOLINT
+        }
+    }
+    return result;
+}
+
+inline const struct PlaybackStats *bufferStats(struct PlaybackBuffer *buffer) {
+    return &buffer->stats;
+}
+
+inline bool bufferIsFull(struct PlaybackBuffer *buffer) {
+    for (uint8_t i = 0; i < PLAYBACK_BUFFER_HALVES; i++) {
+        if (!buffer->halves[i].ready) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool bufferIsEmpty(struct PlaybackBuffer *buffer) {
+    for (uint8_t i = 0; i < PLAYBACK_BUFFER_HALVES; i++) {
+        if (buffer->halves[i].ready) {
+            return false;
+        }
+    }
+    return true;
+}
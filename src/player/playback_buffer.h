@@ -0,0 +1,199 @@
+/**
+ * @file
+ * Ping-pong playback buffer interface.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __PLAYBACK_BUFFER_H__
+#define __PLAYBACK_BUFFER_H__
+
+#include "../hal/platform.h"
+#include "stdbool.h"
+#include "../lib/fat-fs/ff.h"
+#include "sector_source.h"
+#include "sample_decoder.h"
+#include "resampler.h"
+
+/**
+ * @brief Size of a single buffer half, half a sector read through FatFs window.
+ * Sector sized halves do not fit in RAM along with the window and objects of two tracks, see ram_budget.h,
+ * so thresholds measured in buffered samples are derived from @ref PLAYBACK_BUFFER_MINIMUM_HALF_SAMPLES.
+ */
+#define PLAYBACK_BUFFER_HALF_SIZE ((uint16_t) (FF_MAX_SS / 2))
+
+/**
+ * @brief Number of buffer halves, one is played while the other one is refilled.
+ */
+#define PLAYBACK_BUFFER_HALVES 2
+
+/**
+ * @brief Maximum number of raw bytes decoded into a single sample, 16 bit stereo frame.
+ */
+#define PLAYBACK_BUFFER_MAX_FRAME_SIZE 4
+
+/**
+ * @brief Samples of a full half in the worst case of songs played at their own rate, 16 bit stereo.
+ * Songs resampled down to the output rate hold even fewer, left to thresholds computed per song.
+ */
+#define PLAYBACK_BUFFER_MINIMUM_HALF_SAMPLES (PLAYBACK_BUFFER_HALF_SIZE / PLAYBACK_BUFFER_MAX_FRAME_SIZE)
+
+/**
+ * @brief Value played when buffer runs out of samples, middle of unsigned 8 bit range.
+ */
+#define PLAYBACK_BUFFER_SILENCE ((uint8_t) 0x80)
+
+/**
+ * @brief Refill starting with fewer buffered samples than a full half of the song, shifted right by this,
+ * is counted as a near miss. A half holds from 64 samples of 16 bit stereo to 256 of 8 bit mono, fewer if resampled,
+ * so a fixed margin would be a whole half of some songs and a small part of others.
+ */
+#define PLAYBACK_BUFFER_NEAR_MISS_SHIFT 2
+
+/**
+ * @brief Playback telemetry counters, gathered per song.
+ */
+struct PlaybackStats {
+    uint16_t underruns; ///< Number of times output found no half to play and switched to silence.
+    uint16_t nearMisses; ///< Number of refills started with fewer samples left than @ref bufferNearMissSamples.
+    uint16_t minimumFill; ///< Minimum number of buffered samples seen at the start of a refill.
+    uint16_t refills; ///< Number of refilled halves.
+    uint16_t worstRefillDuration; ///< Longest refill, in sample periods.
+};
+
+/**
+ * @brief Single half of @ref PlaybackBuffer.
+ */
+struct PlaybackBufferHalf {
+    uint8_t *begin; ///< First sample to play.
+    uint8_t *end; ///< One past the last sample to play.
+    volatile bool ready; ///< Set after refill, cleared when half was played.
+    FSIZE_t offset; ///< File offset of the frame played first, at @ref begin.
+    uint8_t data[PLAYBACK_BUFFER_HALF_SIZE]; ///< Actual storage, filled by disk reads at its end and decoded in place.
+};
+
+/**
+ * @brief Structure holding internals of PlaybackBuffer.
+ * Exposed only because of performance reasons.
+ */
+struct PlaybackBuffer {
+    uint8_t *readPosition; ///< Next sample to play, owned by output interrupt, first field for its naked version.
+    uint8_t *readEnd; ///< End of currently played half, owned by output interrupt.
+    volatile uint8_t playingHalf; ///< Index of currently played half.
+    volatile bool silent; ///< Set when output plays silence instead of a half.
+    volatile bool endOfStream; ///< Set when the last half was refilled, so starving is not an underrun.
+    uint16_t skip; ///< Number of bytes to skip at the beginning of next refilled half.
+    FSIZE_t nextOffset; ///< File offset of raw data read by next refill.
+    struct SampleDecoder decoder; ///< Decoder of refilled raw data.
+    uint8_t phase; ///< Number of bytes at the beginning of next read, which belong to the previous frame.
+    uint8_t carryLength; ///< Number of bytes in @ref carry.
+    uint8_t carry[PLAYBACK_BUFFER_MAX_FRAME_SIZE]; ///< Beginning of a frame split between reads.
+    struct Resampler resampler; ///< Converter of decoded samples to the output rate.
+    struct PlaybackStats stats; ///< Telemetry counters.
+    struct PlaybackBufferHalf halves[PLAYBACK_BUFFER_HALVES]; ///< Both halves.
+};
+
+/**
+ * @brief Initialize @ref PlaybackBuffer.
+ * @param[in] decoder : Initialized decoder of refilled raw data, it is copied.
+ * @param[in] sampleRate : Sample rate of decoded samples.
+ * @param[in] outputRate : Sample rate of the output, not higher than @p sampleRate.
+ * @return Pointer to newly created playback buffer, @p NULL if the only one exists already.
+ */
+struct PlaybackBuffer *bufferInit(const struct SampleDecoder *decoder, uint32_t sampleRate, uint32_t outputRate);
+
+/**
+ * @brief Destroy @ref PlaybackBuffer.
+ * @param[out] buffer : Pointer to @ref PlaybackBuffer, which will be destroyed.
+ */
+void bufferDestroy(struct PlaybackBuffer *buffer);
+
+/**
+ * @brief Drop buffered samples and move @p source to the read holding @p offset.
+ * Bytes of that read preceding @p offset are skipped by the next refill.
+ * @param[out] buffer : Pointer to buffer.
+ * @param[out] source : Source of file sectors.
+ * @param[in] offset : File offset of the first frame to play, beginning of a block for block based formats.
+ */
+void bufferSeek(struct PlaybackBuffer *buffer, struct SectorSource *source, FSIZE_t offset);
+
+/**
+ * @brief Continue refilling from another song, while buffered samples of the current one are still played.
+ * Output rate has to stay the same, so the output timer keeps running.
+ * Position of the buffered samples is reported as the beginning of the next song.
+ * @param[out] buffer : Pointer to buffer.
+ * @param[out] source : Source of the next song sectors, used by following refills.
+ * @param[in] decoder : Initialized decoder of the next song, it is copied.
+ * @param[in] sampleRate : Sample rate of the next song.
+ * @param[in] outputRate : Sample rate of the output, not higher than @p sampleRate.
+ * @param[in] offset : File offset of the first frame of the next song.
+ */
+void bufferSplice(struct PlaybackBuffer *buffer, struct SectorSource *source, const struct SampleDecoder *decoder,
+                  uint32_t sampleRate, uint32_t outputRate, FSIZE_t offset);
+
+/**
+ * @brief Refill next half, if it was already played, by decoded and resampled raw data from @p source.
+ * Formats expanding while decoding read less than a half, so samples fit in it.
+ * @param[out] source : Source of file sectors.
+ * @param[out] buffer : Pointer to buffer, we want to refill.
+ */
+void sourceRefillBuffer(struct SectorSource *source, struct PlaybackBuffer *buffer);
+
+/**
+ * @brief Switch reading to the other half, called by output interrupt at the end of a half.
+ * If the other half is not refilled yet, silence is played until it is.
+ * @param[out] buffer : Pointer to buffer.
+ */
+void bufferNextHalf(struct PlaybackBuffer *buffer);
+
+/**
+ * @brief Get number of samples left in the playing half, played before it can be refilled.
+ * @param[in] buffer : Pointer to buffer.
+ * @return Number of samples, @p 0 if buffer is starving.
+ */
+uint16_t bufferPlayingSize(struct PlaybackBuffer *buffer);
+
+/**
+ * @brief Get number of buffered samples, which are not played yet.
+ * @param[in] buffer : Pointer to buffer.
+ * @return Number of samples left in the playing half and in the refilled one.
+ */
+uint16_t bufferCurrentSize(struct PlaybackBuffer *buffer);
+
+/**
+ * @brief Get number of buffered samples, below which a refill is counted as a near miss.
+ * @param[in] buffer : Pointer to buffer.
+ * @return Samples of a full half of the song, shifted right by @ref PLAYBACK_BUFFER_NEAR_MISS_SHIFT.
+ */
+uint16_t bufferNearMissSamples(struct PlaybackBuffer *buffer);
+
+/**
+ * @brief Get playing position.
+ * @param[in] buffer : Pointer to buffer.
+ * @return File offset of the sample played now, or played next if buffer is starving.
+ */
+FSIZE_t bufferPosition(struct PlaybackBuffer *buffer);
+
+/**
+ * @brief Get telemetry counters.
+ * @param[in] buffer : Pointer to buffer.
+ * @return Pointer to counters gathered since buffer was initialized.
+ */
+const struct PlaybackStats *bufferStats(struct PlaybackBuffer *buffer);
+
+/**
+ * @brief Check if buffer is full.
+ * @param[in] buffer : Examined buffer.
+ * @return @p true if all halves are waiting to be played, or being played, @p false otherwise.
+ */
+bool bufferIsFull(struct PlaybackBuffer *buffer);
+
+/**
+ * @brief Check if buffer is empty.
+ * @param[in] buffer : Examined buffer.
+ * @return @p true if no half is waiting to be played, @p false otherwise.
+ */
+bool bufferIsEmpty(struct PlaybackBuffer *buffer);
+
+#endif /* __PLAYBACK_BUFFER_H__ */
@@ -0,0 +1,53 @@
+/**
+ * @file
+ * Fixed point sample rate converter implementation.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include "resampler.h"
+
+void resamplerInit(struct Resampler *resampler, uint32_t inputRate, uint32_t outputRate) {
+    resampler->step = (uint16_t) (((inputRate << 8) + outputRate / 2) / outputRate); // NOLINT
+    if (resampler->step < RESAMPLER_UNITY) {
+        resampler->step = RESAMPLER_UNITY;
+    }
+    resamplerReset(resampler);
+}
+
+void resamplerReset(struct Resampler *resampler) {
+    // First input sample becomes the previous one, without producing output.
+    resampler->phase = RESAMPLER_UNITY;
+    resampler->previous = 0;
+}
+
+inline bool resamplerIsUnity(const struct Resampler *resampler) {
+    return resampler->step == RESAMPLER_UNITY;
+}
+
+uint16_t resamplerProcess(struct Resampler *resampler, uint8_t *data, uint16_t length) {
+    const uint8_t *input = data;
+    const uint8_t *inputEnd = data + length;
+    uint8_t *output = data;
+    uint8_t current = resampler->previous;
+    uint16_t phase = resampler->phase;
+
+    // Step is at least one input sample, so output never overtakes input.
+    for (;;) {
+        while (phase >= RESAMPLER_UNITY && input != inputEnd) {
+            current = *input++;
+            phase -= RESAMPLER_UNITY;
+        }
+        if (input == inputEnd) {
+            break;
+        }
+        // Weight reduced to 7 bits, so the product fits in 16 bits.
+        int16_t difference = (int16_t) *input - current;
+        *output++ = (uint8_t) (current + ((difference * (int16_t) (phase >> 1)) >> 7)); // NOLINT
+        phase += resampler->step;
+    }
+    resampler->previous = current;
+    resampler->phase = phase;
+    return (uint16_t) (output - data);
+}
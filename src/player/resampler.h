@@ -0,0 +1,60 @@
+/**
+ * @file
+ * Fixed point sample rate converter interface.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __RESAMPLER_H__
+#define __RESAMPLER_H__
+
+#include "../hal/platform.h"
+#include <stdbool.h>
+
+/**
+ * @brief Position step equal to a single input sample, 1.0 in Q8.8.
+ */
+#define RESAMPLER_UNITY ((uint16_t) 256)
+
+/**
+ * @brief Structure holding resampler state, carried between sectors.
+ * Exposed only because it is embedded in @ref PlaybackBuffer.
+ */
+struct Resampler {
+    uint16_t step; ///< Input samples advanced per output sample, Q8.8.
+    uint16_t phase; ///< Position of the next output sample after @ref previous, Q8.8.
+    uint8_t previous; ///< Last input sample of the previous sector.
+};
+
+/**
+ * @brief Initialize @ref Resampler converting @p inputRate down to @p outputRate.
+ * @param[out] resampler : Pointer to resampler.
+ * @param[in] inputRate : Sample rate of decoded samples.
+ * @param[in] outputRate : Sample rate of the output, not higher than @p inputRate.
+ */
+void resamplerInit(struct Resampler *resampler, uint32_t inputRate, uint32_t outputRate);
+
+/**
+ * @brief Forget samples of the previous sector, e.g. after seek.
+ * @param[out] resampler : Pointer to resampler.
+ */
+void resamplerReset(struct Resampler *resampler);
+
+/**
+ * @brief Check if resampler passes samples unchanged.
+ * @param[in] resampler : Pointer to resampler.
+ * @return @p true if input and output rates are equal, @p false otherwise.
+ */
+bool resamplerIsUnity(const struct Resampler *resampler);
+
+/**
+ * @brief Resample in place, interpolating linearly between neighbouring input samples.
+ * @param[out] resampler : Pointer to resampler.
+ * @param[out] data : Input samples, replaced by output ones.
+ * @param[in] length : Number of input samples.
+ * @return Number of output samples.
+ */
+uint16_t resamplerProcess(struct Resampler *resampler, uint8_t *data, uint16_t length);
+
+#endif /* __RESAMPLER_H__ */
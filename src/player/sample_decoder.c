@@ -0,0 +1,271 @@
+/**
+ * @file
+ * Sample decoders implementation.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "sample_decoder.h"
+#include "playback_buffer.h"
+#include "wav_file.h"
+
+/**
+ * @brief Value flipping sign bit, turning signed sample into biased unsigned one.
+ */
+#define SIGN_BIAS ((uint8_t) 0x80)
+
+/**
+ * @brief Size of IMA ADPCM block header: initial sample, step index and reserved byte.
+ */
+#define IMA_ADPCM_HEADER_SIZE 4
+
+/**
+ * @brief Highest IMA ADPCM step index.
+ */
+#define IMA_ADPCM_MAX_STEP_INDEX 88
+
+/**
+ * @brief IMA ADPCM quantizer steps, indexed by step index.
+ */
+static const int16_t imaAdpcmSteps[IMA_ADPCM_MAX_STEP_INDEX + 1] PROGMEM = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+        107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+        876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428,
+        4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
+        22385, 24623, 27086, 29794, 32767
+};
+
+/**
+ * @brief IMA ADPCM step index changes, indexed by a nibble without its sign bit.
+ */
+static const int8_t imaAdpcmIndexChanges[8] PROGMEM = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+/**
+ * @brief G.711 A-law codewords expanded to linear samples, high byte biased to unsigned.
+ */
+static const uint8_t aLawSamples[256] PROGMEM = {
+        0x6a, 0x6b, 0x68, 0x69, 0x6e, 0x6f, 0x6c, 0x6d, 0x62, 0x63, 0x60, 0x61, 0x66, 0x67, 0x64, 0x65,
+        0x75, 0x75, 0x74, 0x74, 0x77, 0x77, 0x76, 0x76, 0x71, 0x71, 0x70, 0x70, 0x73, 0x73, 0x72, 0x72,
+        0x2a, 0x2e, 0x22, 0x26, 0x3a, 0x3e, 0x32, 0x36, 0x0a, 0x0e, 0x02, 0x06, 0x1a, 0x1e, 0x12, 0x16,
+        0x55, 0x57, 0x51, 0x53, 0x5d, 0x5f, 0x59, 0x5b, 0x45, 0x47, 0x41, 0x43, 0x4d, 0x4f, 0x49, 0x4b,
+        0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e,
+        0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f,
+        0x7a, 0x7a, 0x7a, 0x7a, 0x7b, 0x7b, 0x7b, 0x7b, 0x78, 0x78, 0x78, 0x78, 0x79, 0x79, 0x79, 0x79,
+        0x7d, 0x7d, 0x7d, 0x7d, 0x7d, 0x7d, 0x7d, 0x7d, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c, 0x7c,
+        0x95, 0x94, 0x97, 0x96, 0x91, 0x90, 0x93, 0x92, 0x9d, 0x9c, 0x9f, 0x9e, 0x99, 0x98, 0x9b, 0x9a,
+        0x8a, 0x8a, 0x8b, 0x8b, 0x88, 0x88, 0x89, 0x89, 0x8e, 0x8e, 0x8f, 0x8f, 0x8c, 0x8c, 0x8d, 0x8d,
+        0xd6, 0xd2, 0xde, 0xda, 0xc6, 0xc2, 0xce, 0xca, 0xf6, 0xf2, 0xfe, 0xfa, 0xe6, 0xe2, 0xee, 0xea,
+        0xab, 0xa9, 0xaf, 0xad, 0xa3, 0xa1, 0xa7, 0xa5, 0xbb, 0xb9, 0xbf, 0xbd, 0xb3, 0xb1, 0xb7, 0xb5,
+        0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81,
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+        0x85, 0x85, 0x85, 0x85, 0x84, 0x84, 0x84, 0x84, 0x87, 0x87, 0x87, 0x87, 0x86, 0x86, 0x86, 0x86,
+        0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x83, 0x83, 0x83, 0x83, 0x83, 0x83, 0x83, 0x83
+};
+
+/**
+ * @brief G.711 mu-law codewords expanded to linear samples, high byte biased to unsigned.
+ */
+static const uint8_t muLawSamples[256] PROGMEM = {
+        0x02, 0x06, 0x0a, 0x0e, 0x12, 0x16, 0x1a, 0x1e, 0x22, 0x26, 0x2a, 0x2e, 0x32, 0x36, 0x3a, 0x3e,
+        0x41, 0x43, 0x45, 0x47, 0x49, 0x4b, 0x4d, 0x4f, 0x51, 0x53, 0x55, 0x57, 0x59, 0x5b, 0x5d, 0x5f,
+        0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70,
+        0x70, 0x71, 0x71, 0x72, 0x72, 0x73, 0x73, 0x74, 0x74, 0x75, 0x75, 0x76, 0x76, 0x77, 0x77, 0x78,
+        0x78, 0x78, 0x79, 0x79, 0x79, 0x79, 0x7a, 0x7a, 0x7a, 0x7a, 0x7b, 0x7b, 0x7b, 0x7b, 0x7c, 0x7c,
+        0x7c, 0x7c, 0x7c, 0x7c, 0x7d, 0x7d, 0x7d, 0x7d, 0x7d, 0x7d, 0x7d, 0x7d, 0x7e, 0x7e, 0x7e, 0x7e,
+        0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7e, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f,
+        0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x80,
+        0xfd, 0xf9, 0xf5, 0xf1, 0xed, 0xe9, 0xe5, 0xe1, 0xdd, 0xd9, 0xd5, 0xd1, 0xcd, 0xc9, 0xc5, 0xc1,
+        0xbe, 0xbc, 0xba, 0xb8, 0xb6, 0xb4, 0xb2, 0xb0, 0xae, 0xac, 0xaa, 0xa8, 0xa6, 0xa4, 0xa2, 0xa0,
+        0x9e, 0x9d, 0x9c, 0x9b, 0x9a, 0x99, 0x98, 0x97, 0x96, 0x95, 0x94, 0x93, 0x92, 0x91, 0x90, 0x8f,
+        0x8f, 0x8e, 0x8e, 0x8d, 0x8d, 0x8c, 0x8c, 0x8b, 0x8b, 0x8a, 0x8a, 0x89, 0x89, 0x88, 0x88, 0x87,
+        0x87, 0x87, 0x86, 0x86, 0x86, 0x86, 0x85, 0x85, 0x85, 0x85, 0x84, 0x84, 0x84, 0x84, 0x83, 0x83,
+        0x83, 0x83, 0x83, 0x83, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x82, 0x81, 0x81, 0x81, 0x81,
+        0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x81, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+        0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80
+};
+
+bool sampleDecoderInit(struct SampleDecoder *decoder, uint16_t formatTag, uint16_t bitsPerSample,
+                       uint16_t numberOfChannels, uint16_t blockAlign) {
+    decoder->decode = NULL;
+    decoder->blockAlign = blockAlign;
+    decoder->readSize = PLAYBACK_BUFFER_HALF_SIZE;
+    if (formatTag == WAV_FORMAT_PCM && blockAlign == numberOfChannels * (bitsPerSample / 8)) {
+        if (numberOfChannels == 1) {
+            decoder->decode = bitsPerSample == 8 ? decodePcm8 : bitsPerSample == 16 ? decodePcm16 : NULL;
+        }
+        else if (numberOfChannels == 2) {
+            decoder->decode = bitsPerSample == 8 ? decodePcm8Stereo : bitsPerSample == 16 ? decodePcm16Stereo : NULL;
+        }
+        decoder->frameSize = (uint8_t) blockAlign;
+        decoder->bytesPerSample = blockAlign << 8; // NOLINT
+    }
+    else if ((formatTag == WAV_FORMAT_ALAW || formatTag == WAV_FORMAT_MULAW) && bitsPerSample == 8
+             && numberOfChannels == 1 && blockAlign == 1) {
+        decoder->decode = formatTag == WAV_FORMAT_ALAW ? decodeALaw : decodeMuLaw;
+        decoder->frameSize = 1;
+        decoder->bytesPerSample = 1 << 8; // NOLINT
+    }
+    else if (formatTag == WAV_FORMAT_IMA_ADPCM && bitsPerSample == 4 && numberOfChannels == 1
+             && blockAlign > IMA_ADPCM_HEADER_SIZE && blockAlign <= INT16_MAX / 2) {
+        decoder->decode = decodeImaAdpcm;
+        // Decoded byte by byte, expanding to twice its size, so half of a half is read at once.
+        decoder->frameSize = 1;
+        decoder->readSize = PLAYBACK_BUFFER_HALF_SIZE / 2;
+        uint16_t samplesPerBlock = (blockAlign - IMA_ADPCM_HEADER_SIZE) * 2 + 1;
+        decoder->bytesPerSample = (uint16_t) (((uint32_t) blockAlign << 8) / samplesPerBlock); // NOLINT
+    }
+    sampleDecoderReset(decoder);
+    return decoder->decode != NULL;
+}
+
+void sampleDecoderReset(struct SampleDecoder *decoder) {
+    decoder->blockPosition = 0;
+    decoder->predictor = 0;
+    decoder->stepIndex = 0;
+}
+
+uint16_t decodePcm8(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length) {
+    (void) decoder;
+    if (output != input) {
+        memmove(output, input, length);
+    }
+    return length;
+}
+
+uint16_t decodePcm16(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length) {
+    (void) decoder;
+    uint16_t samples = length / 2;
+    // Little endian, so every second byte, starting from the second one, is a high byte.
+    input++;
+    for (uint16_t i = samples; i != 0; i--) {
+        *output++ = *input ^ SIGN_BIAS; // NOLINT
+        input += 2;
+    }
+    return samples;
+}
+
+uint16_t decodePcm8Stereo(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length) {
+    (void) decoder;
+    uint16_t samples = length / 2;
+    for (uint16_t i = samples; i != 0; i--) {
+        uint16_t left = *input++;
+        *output++ = (uint8_t) ((left + *input++) >> 1); // NOLINT
+    }
+    return samples;
+}
+
+uint16_t decodePcm16Stereo(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length) {
+    (void) decoder;
+    uint16_t samples = length / 4;
+    input++;
+    for (uint16_t i = samples; i != 0; i--) {
+        int16_t left = (int8_t) input[0];
+        int16_t right = (int8_t) input[2];
+        *output++ = (uint8_t) ((left + right) >> 1) ^ SIGN_BIAS; // NOLINT
+        input += 4;
+    }
+    return samples;
+}
+
+/**
+ * @brief Expand companded samples through a table in flash.
+ * @param[in] table : Table of 256 samples, indexed by codewords.
+ * @param[out] output : First output sample.
+ * @param[in] input : Codewords.
+ * @param[in] length : Number of codewords.
+ * @return Number of output samples.
+ */
+static inline uint16_t decodeThroughTable(const uint8_t *table, uint8_t *output, const uint8_t *input,
+                                          uint16_t length) {
+    for (uint16_t i = length; i != 0; i--) {
+        *output++ = pgm_read_byte(table + *input++);
+    }
+    return length;
+}
+
+uint16_t decodeALaw(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length) {
+    (void) decoder;
+    return decodeThroughTable(aLawSamples, output, input, length);
+}
+
+uint16_t decodeMuLaw(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length) {
+    (void) decoder;
+    return decodeThroughTable(muLawSamples, output, input, length);
+}
+
+/**
+ * @brief Decode a single IMA ADPCM nibble.
+ * @param[out] decoder : Decoder holding predictor and step index.
+ * @param[in] nibble : Encoded difference, sign bit and 3 bits of magnitude.
+ * @return Decoded sample, biased to unsigned 8 bits.
+ */
+static inline uint8_t decodeImaAdpcmNibble(struct SampleDecoder *decoder, uint8_t nibble) {
+    int16_t step = (int16_t) pgm_read_word(&imaAdpcmSteps[decoder->stepIndex]);
+    int32_t difference = step >> 3; // NOLINT
+    if (nibble & 1) { // NOLINT
+        difference += step >> 2; // NOLINT
+    }
+    if (nibble & 2) { // NOLINT
+        difference += step >> 1; // NOLINT
+    }
+    if (nibble & 4) { // NOLINT
+        difference += step;
+    }
+
+    int32_t predictor = decoder->predictor;
+    predictor += nibble & 8 ? -difference : difference; // NOLINT
+    if (predictor > INT16_MAX) {
+        predictor = INT16_MAX;
+    }
+    else if (predictor < INT16_MIN) {
+        predictor = INT16_MIN;
+    }
+    decoder->predictor = (int16_t) predictor;
+
+    int8_t stepIndex = (int8_t) (decoder->stepIndex + (int8_t) pgm_read_byte(&imaAdpcmIndexChanges[nibble & 7])); // NOLINT
+    if (stepIndex < 0) {
+        stepIndex = 0;
+    }
+    else if (stepIndex > IMA_ADPCM_MAX_STEP_INDEX) {
+        stepIndex = IMA_ADPCM_MAX_STEP_INDEX;
+    }
+    decoder->stepIndex = (uint8_t) stepIndex;
+
+    return (uint8_t) (decoder->predictor >> 8) ^ SIGN_BIAS; // NOLINT
+}
+
+uint16_t decodeImaAdpcm(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length) {
+    const uint8_t *inputEnd = input + length;
+    uint8_t *outputBegin = output;
+    // Block header may be split between calls, so it is decoded byte by byte too.
+    while (input != inputEnd) {
+        uint8_t byte = *input++;
+        switch (decoder->blockPosition) {
+            case 0:
+                decoder->predictor = byte;
+                break;
+            case 1:
+                decoder->predictor = (int16_t) ((uint16_t) decoder->predictor | (uint16_t) byte << 8); // NOLINT
+                // Initial sample of a block is stored uncompressed.
+                *output++ = (uint8_t) (decoder->predictor >> 8) ^ SIGN_BIAS; // NOLINT
+                break;
+            case 2:
+                decoder->stepIndex = byte <= IMA_ADPCM_MAX_STEP_INDEX ? byte : IMA_ADPCM_MAX_STEP_INDEX;
+                break;
+            case 3:
+                break;
+            default:
+                // Earlier sample in the low nibble.
+                *output++ = decodeImaAdpcmNibble(decoder, byte & 0x0f); // NOLINT
+                *output++ = decodeImaAdpcmNibble(decoder, byte >> 4); // NOLINT
+                break;
+        }
+        if (++decoder->blockPosition == decoder->blockAlign) {
+            decoder->blockPosition = 0;
+        }
+    }
+    return (uint16_t) (output - outputBegin);
+}
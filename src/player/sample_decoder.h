@@ -0,0 +1,97 @@
+/**
+ * @file
+ * Sample decoders interface, converting raw song data to unsigned 8 bit DAC samples.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __SAMPLE_DECODER_H__
+#define __SAMPLE_DECODER_H__
+
+#include "../hal/platform.h"
+#include <stdbool.h>
+
+struct SampleDecoder;
+
+/**
+ * @brief Function converting raw samples to unsigned 8 bit ones.
+ * Output may overlap input, as long as it starts at most as far, as samples expand.
+ * @param[out] decoder : Decoder state, carried between calls.
+ * @param[out] output : First output sample.
+ * @param[in] input : Raw samples, a whole number of frames.
+ * @param[in] length : Number of raw bytes.
+ * @return Number of output samples.
+ */
+typedef uint16_t (*SampleDecodeFunction)(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input,
+                                         uint16_t length);
+
+/**
+ * @brief Structure holding decoder of a song format and its state.
+ * Exposed only because it is embedded in @ref PlaybackBuffer.
+ */
+struct SampleDecoder {
+    SampleDecodeFunction decode; ///< Format specific decoding function.
+    uint8_t frameSize; ///< Number of raw bytes decoded together, frames are never split between calls.
+    uint16_t readSize; ///< Number of raw bytes, which decode into at most a buffer half.
+    uint16_t bytesPerSample; ///< Average number of raw bytes per output sample, Q8.8.
+    uint16_t blockAlign; ///< Size of independently decodable block of raw data.
+    uint16_t blockPosition; ///< Number of bytes of current block already decoded.
+    int16_t predictor; ///< Last decoded sample of adaptive formats.
+    uint8_t stepIndex; ///< Quantizer step index of adaptive formats.
+};
+
+/**
+ * @brief Choose decoder of samples.
+ * @param[out] decoder : Decoder to initialize.
+ * @param[in] formatTag : Format tag from wav file properties.
+ * @param[in] bitsPerSample : Bits per sample from wav file properties.
+ * @param[in] numberOfChannels : Number of channels from wav file properties.
+ * @param[in] blockAlign : Block align from wav file properties.
+ * @return @p true on success, @p false if the format is not supported.
+ */
+bool sampleDecoderInit(struct SampleDecoder *decoder, uint16_t formatTag, uint16_t bitsPerSample,
+                       uint16_t numberOfChannels, uint16_t blockAlign);
+
+/**
+ * @brief Forget decoding state, next input starts a block, e.g. after seek.
+ * @param[out] decoder : Pointer to decoder.
+ */
+void sampleDecoderReset(struct SampleDecoder *decoder);
+
+/**
+ * @brief Decoder of unsigned 8 bit mono PCM, samples are played as they are.
+ */
+uint16_t decodePcm8(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length);
+
+/**
+ * @brief Decoder of signed 16 bit little endian mono PCM, high bytes are biased to unsigned.
+ */
+uint16_t decodePcm16(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length);
+
+/**
+ * @brief Decoder of unsigned 8 bit stereo PCM, channels are mixed down to mono.
+ */
+uint16_t decodePcm8Stereo(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length);
+
+/**
+ * @brief Decoder of signed 16 bit little endian stereo PCM, high bytes of channels are mixed down to mono.
+ */
+uint16_t decodePcm16Stereo(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length);
+
+/**
+ * @brief Decoder of 8 bit mono G.711 A-law, a single table lookup per sample.
+ */
+uint16_t decodeALaw(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length);
+
+/**
+ * @brief Decoder of 8 bit mono G.711 mu-law, a single table lookup per sample.
+ */
+uint16_t decodeMuLaw(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length);
+
+/**
+ * @brief Decoder of 4 bit mono IMA ADPCM, every raw byte expands to two samples.
+ */
+uint16_t decodeImaAdpcm(struct SampleDecoder *decoder, uint8_t *output, const uint8_t *input, uint16_t length);
+
+#endif /* __SAMPLE_DECODER_H__ */
@@ -0,0 +1,191 @@
+/**
+ * @file
+ * Raw sector source of song data implementation.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "sector_source.h"
+#include "../lib/fat-fs/diskio.h"
+
+/**
+ * @brief Source of file sectors, bypassing FatFs if file fragments fit in the link map.
+ */
+struct SectorSource {
+    FIL *file; ///< Source file.
+    bool mapping; ///< Flag indicating if @ref linkMap is still being built, @ref position is the next cluster then.
+    bool mapped; ///< Flag indicating if all fragments fit in @ref linkMap.
+    DWORD linkMap[SECTOR_SOURCE_LINK_MAP_SIZE]; ///< FatFs cluster link map, see f_lseek.
+    DWORD *fragment; ///< Length of current fragment in @ref linkMap, followed by its first cluster.
+    DWORD sector; ///< Disk sector holding @ref position.
+    DWORD sectorsLeft; ///< Number of sectors left in current fragment, including @ref sector.
+    FSIZE_t position; ///< File offset read next.
+    FSIZE_t end; ///< File offset, at which source ends.
+};
+
+RAM_BUDGET_CHECK(sizeof(struct SectorSource), SECTOR_SOURCE_RAM_BUDGET);
+
+/**
+ * @brief Get first disk sector of a cluster.
+ * @param[in] fs : Filesystem holding the cluster.
+ * @param[in] cluster : Cluster number.
+ * @return Sector number.
+ */
+static inline DWORD clusterToSector(const FATFS *fs, DWORD cluster) {
+    return fs->database + (DWORD) fs->csize * (cluster - 2);
+}
+
+struct SectorSource *sectorSourceInit(FIL *file, FSIZE_t end, struct Arena *arena) {
+    struct SectorSource *result = arenaAllocate(arena, sizeof(struct SectorSource));
+    if (result == NULL) {
+        return NULL;
+    }
+    result->file = file;
+    result->end = end < f_size(file) ? end : f_size(file);
+    result->mapping = true;
+    result->mapped = false;
+    result->linkMap[1] = 0;
+    result->fragment = result->linkMap + 1;
+    result->position = 0;
+    return result;
+}
+
+/**
+ * @brief Finish building the link map, attach it to the file if all fragments fit in.
+ * @param[out] source : Pointer to sector source.
+ * @param[in] mapped : Flag indicating if all fragments fit in the link map.
+ */
+static void sectorSourceMapDone(struct SectorSource *source, bool mapped) {
+    source->mapping = false;
+    source->mapped = mapped;
+    if (mapped) {
+        // Terminated after the last fragment, FatFs reads the used size only when it builds the map itself.
+        DWORD *terminator = source->fragment[0] ? source->fragment + 2 : source->fragment;
+        terminator[0] = 0;
+        source->linkMap[0] = (DWORD) (terminator - source->linkMap + 1);
+        source->file->cltbl = source->linkMap;
+    }
+    sectorSourceSeek(source, 0);
+}
+
+bool sectorSourceMapStep(struct SectorSource *source) {
+    if (!source->mapping) {
+        return true;
+    }
+    FIL *file = source->file;
+    DWORD clusterSize = (DWORD) file->obj.fs->csize * FF_MAX_SS;
+    for (uint8_t clusters = 0; clusters < SECTOR_SOURCE_MAP_STEP_CLUSTERS; clusters++) {
+        if (source->position >= f_size(file)) {
+            sectorSourceMapDone(source, true);
+            return true;
+        }
+        // Seeking a cluster forward follows a single FAT entry, sector holding it is mostly cached in the window.
+        if (f_lseek(file, source->position + 1) != FR_OK) {
+            sectorSourceMapDone(source, false);
+            return true;
+        }
+        source->position += clusterSize;
+        DWORD *fragment = source->fragment;
+        if (fragment[0] && file->clust == fragment[1] + fragment[0]) {
+            fragment[0]++;
+            continue;
+        }
+        if (fragment[0]) {
+            fragment += 2;
+        }
+        if (fragment + 2 >= source->linkMap + SECTOR_SOURCE_LINK_MAP_SIZE) {
+            sectorSourceMapDone(source, false);
+            return true;
+        }
+        fragment[0] = 1;
+        fragment[1] = file->clust;
+        source->fragment = fragment;
+        // Entries of the next fragment are elsewhere in the FAT, they are left to the next step.
+        break;
+    }
+    return false;
+}
+
+void sectorSourceDestroy(struct SectorSource *source) {
+    if (source != NULL) {
+        source->file->cltbl = NULL;
+        disk_stream_close(source->file->obj.fs->pdrv);
+    }
+}
+
+void sectorSourceSeek(struct SectorSource *source, FSIZE_t offset) {
+    source->position = offset;
+    if (!source->mapped) {
+        f_lseek(source->file, offset);
+        return;
+    }
+
+    const FATFS *fs = source->file->obj.fs;
+    DWORD index = offset / FF_MAX_SS;
+    DWORD *fragment = source->linkMap + 1;
+    for (; fragment[0]; fragment += 2) {
+        DWORD length = fragment[0] * fs->csize;
+        if (index < length) {
+            source->sector = clusterToSector(fs, fragment[1]) + index;
+            source->sectorsLeft = length - index;
+            break;
+        }
+        index -= length;
+    }
+    if (!fragment[0]) {
+        source->sectorsLeft = 0;
+    }
+    source->fragment = fragment;
+}
+
+UINT sectorSourceRead(struct SectorSource *source, BYTE *buffer, UINT size) {
+    if (source->position >= source->end) {
+        return 0;
+    }
+    FSIZE_t left = source->end - source->position;
+    UINT read = left < size ? (UINT) left : size;
+    if (!source->mapped) {
+        f_read(source->file, buffer, read, &read);
+        source->position += read;
+        return read;
+    }
+
+    FATFS *fs = source->file->obj.fs;
+    if (source->sectorsLeft == 0) {
+        if (!source->fragment[0] || !source->fragment[2]) {
+            return 0;
+        }
+        source->fragment += 2;
+        source->sector = clusterToSector(fs, source->fragment[1]);
+        source->sectorsLeft = source->fragment[0] * fs->csize;
+    }
+
+    // Consecutive sectors continue the disk read stream, so only a fragment change costs a command.
+    // Window is a valid cache of the sector afterwards, FatFs keeps using it.
+    UINT inSector = (UINT) source->position & (FF_MAX_SS - 1); // NOLINT
+    if (fs->winsect != source->sector) {
+        if (disk_read(fs->pdrv, fs->win, source->sector, 1) != RES_OK) {
+            fs->winsect = (DWORD) -1;
+            return 0;
+        }
+        fs->winsect = source->sector;
+    }
+    memcpy(buffer, fs->win + inSector, read);
+    if (inSector + size == FF_MAX_SS) {
+        source->sector++;
+        source->sectorsLeft--;
+    }
+    source->position += read;
+    return read;
+}
+
+inline bool sectorSourceEof(struct SectorSource *source) {
+    return source->position >= source->end;
+}
+
+inline bool sectorSourceIsMapped(struct SectorSource *source) {
+    return source->mapped;
+}
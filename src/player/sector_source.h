@@ -0,0 +1,108 @@
+/**
+ * @file
+ * Raw sector source of song data interface.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __SECTOR_SOURCE_H__
+#define __SECTOR_SOURCE_H__
+
+#include <stdbool.h>
+#include "../lib/fat-fs/ff.h"
+#include "../memory/arena.h"
+#include "../memory/ram_budget.h"
+
+#ifdef SD_STATISTICS
+/**
+ * @brief Maximum number of file fragments read directly from the disk.
+ * More fragmented files are read by FatFs.
+ * Disk statistics take RAM of three fragments of both tracks, see main.c.
+ */
+#define SECTOR_SOURCE_MAX_FRAGMENTS 5
+#else
+/**
+ * @brief Maximum number of file fragments read directly from the disk.
+ * More fragmented files are read by FatFs.
+ */
+#define SECTOR_SOURCE_MAX_FRAGMENTS 8
+#endif /* SD_STATISTICS */
+
+/**
+ * @brief Size of cluster link map: used size, pair of length and first cluster per fragment and terminator.
+ */
+#define SECTOR_SOURCE_LINK_MAP_SIZE (2 + 2 * SECTOR_SOURCE_MAX_FRAGMENTS)
+
+/**
+ * @brief Maximum number of clusters followed by a single step of building the link map.
+ * Their FAT entries are consecutive and a sector of 32 bit FAT holds as many, so a step reads at most two FAT sectors.
+ */
+#define SECTOR_SOURCE_MAP_STEP_CLUSTERS (FF_MAX_SS / 4)
+
+/**
+ * @brief Arena bytes taken by @ref SectorSource, mostly its link map.
+ */
+#define SECTOR_SOURCE_RAM_BUDGET ((24 + 4 * SECTOR_SOURCE_LINK_MAP_SIZE) * RAM_BUDGET_SCALE)
+
+/**
+ * @brief Source of file sectors, bypassing FatFs if file fragments fit in the link map.
+ */
+struct SectorSource;
+
+/**
+ * @brief Initialize @ref SectorSource, its cluster link map is built by @ref sectorSourceMapStep.
+ * @param[out] file : Opened file, it uses the link map for seeking too.
+ * @param[in] end : File offset, at which source ends, e.g. end of song data.
+ * @param[out] arena : Arena, from which sector source is allocated, it is released with the arena.
+ * @return Pointer to newly created sector source, @p NULL if @p arena is exhausted.
+ */
+struct SectorSource *sectorSourceInit(FIL *file, FSIZE_t end, struct Arena *arena);
+
+/**
+ * @brief Follow a part of the cluster chain of the file into the link map, one fragment at most.
+ * Sector source can be read only after the map is complete, files with more fragments than fit are read by FatFs.
+ * @param[out] source : Pointer to sector source.
+ * @return @p true if the link map is complete, @p false if more steps are needed.
+ */
+bool sectorSourceMapStep(struct SectorSource *source);
+
+/**
+ * @brief Destroy @ref SectorSource, detaching its link map from the file.
+ * @param[out] source : Pointer to structure, which will be destroyed.
+ */
+void sectorSourceDestroy(struct SectorSource *source);
+
+/**
+ * @brief Move to a read boundary.
+ * @param[out] source : Pointer to sector source.
+ * @param[in] offset : File offset, multiple of the size of following reads.
+ */
+void sectorSourceSeek(struct SectorSource *source, FSIZE_t offset);
+
+/**
+ * @brief Read next part of a sector.
+ * Sector is read into FatFs window and the part is copied from there. It costs a copy of every byte,
+ * but playback buffer halves are smaller than a sector and the window is the only sector sized RAM.
+ * @param[out] source : Pointer to sector source.
+ * @param[out] buffer : Buffer of @p size bytes.
+ * @param[in] size : Number of bytes to read, proper divisor of a sector size.
+ * @return Number of read bytes, less than @p size only at the end of source.
+ */
+UINT sectorSourceRead(struct SectorSource *source, BYTE *buffer, UINT size);
+
+/**
+ * @brief Check if all sectors were read.
+ * @param[in] source : Pointer to sector source.
+ * @return @p true if at the end of source, @p false otherwise.
+ */
+bool sectorSourceEof(struct SectorSource *source);
+
+/**
+ * @brief Check if sectors are read directly from the disk.
+ * @param[in] source : Pointer to sector source.
+ * @return @p true if file is mapped, @p false if it is read by FatFs.
+ */
+bool sectorSourceIsMapped(struct SectorSource *source);
+
+#endif /* __SECTOR_SOURCE_H__ */
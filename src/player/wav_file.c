@@ -6,19 +6,20 @@
  * @date 12.06.2018
  */
 
-#include <avr/io.h>
 #include <stdlib.h>
-#include <assert.h>
 #include <string.h>
+#include <stdbool.h>
 #include "wav_file.h"
-#include "../view/screen_utils.h"
 
 /**
- * @brief Structure representing wav file properties.
+ * @brief Structure representing wav file properties, laid out as the @p fmt chunk.
  */
 struct WavFileInfo {
+    uint16_t formatTag; ///< Encoding of samples, see @ref WAV_FORMAT_PCM.
     uint16_t numberOfChannels; ///< @p 1 - mono, or @p 2 - stereo, expecting mono.
     uint32_t sampleRate; ///< We expect @p 8khz
+    uint32_t byteRate; ///< Number of raw data bytes per second.
+    uint16_t blockAlign; ///< Size in bytes of a frame, samples of all channels.
     uint16_t bitsPerSample; ///< We expect 8 bits per sample.
 };
 
@@ -27,77 +28,91 @@ struct WavFileInfo {
  */
 struct WavFile {
     struct WavFileInfo info; ///< properties
+    FSIZE_t dataOffset; ///< File offset of raw data.
+    uint32_t dataSize; ///< Size of raw data in bytes.
     FIL *file; ///< file, which we are representing.
 };
 
-/**
- * @brief File offset from zero in bytes of number of channels property.
- */
-#define NUMBER_OF_CHANNELS_OFFSET 22
-
-/**
- * @brief File offset from zero in bytes of sample rate property.
- */
-#define SAMPLE_RATE_OFFSET 24
+RAM_BUDGET_CHECK(sizeof(struct WavFile), WAV_FILE_RAM_BUDGET);
 
 /**
- * @brief File offset from zero in bytes of bits per sample property.
+ * @brief Header preceding every RIFF chunk.
  */
-#define BITS_PER_SAMPLE_OFFSET 34
+struct RiffChunkHeader {
+    char id[4]; ///< Chunk type.
+    uint32_t size; ///< Size of chunk body, without padding byte.
+};
 
 /**
- * @brief File offset from zero in bytes of raw data.
+ * @brief Read exactly @p size bytes.
+ * @param[out] file : Source file.
+ * @param[out] buffer : Destination.
+ * @param[in] size : Number of bytes to read.
+ * @return @p true on success, @p false on error or end of file.
  */
-#define WAV_FILE_DATA_OFFSET 44
-
-struct WavFile *wavFileLoad(FIL *file) {
-    struct WavFile *result = malloc(sizeof(struct WavFile));
-    assert(result);
-    size_t read;
-    f_lseek(file, NUMBER_OF_CHANNELS_OFFSET);
-    f_read(file, (uint8_t *) &result->info.numberOfChannels, sizeof(result->info.numberOfChannels), &read);
-    f_lseek(file, SAMPLE_RATE_OFFSET);
-    f_read(file, (uint8_t *) &result->info.sampleRate, sizeof(result->info.sampleRate), &read);
-    f_lseek(file, BITS_PER_SAMPLE_OFFSET);
-    f_read(file, (uint8_t *) &result->info.bitsPerSample, sizeof(result->info.bitsPerSample), &read);
-    result->file = file;
-    f_lseek(file, WAV_FILE_DATA_OFFSET);
-    return result;
+static bool readExactly(FIL *file, void *buffer, UINT size) {
+    UINT read;
+    return f_read(file, buffer, size, &read) == FR_OK && read == size;
 }
 
 /**
- * @brief Print number to a display.
- * @param[in] number : number, which will be printed.
+ * @brief Skip rest of a chunk body and its padding byte.
+ * Malformed sizes could wrap the offset around, back to an already read chunk, so bodies past the end are rejected.
+ * @param[out] file : Source file.
+ * @param[in] left : Number of bytes left in the chunk body.
+ * @return @p true on success, @p false if the body does not fit in the file, or on error.
  */
-static void printNumber(int32_t number) {
-    char buffer[10] = {0};
-    ltoa(number, buffer, 10);
-    print(buffer);
-    write('\n');
+static bool skipChunk(FIL *file, uint32_t left) {
+    if (left > f_size(file) - f_tell(file)) {
+        return false;
+    }
+    return f_lseek(file, f_tell(file) + left + (left & 1)) == FR_OK;
 }
 
-void wavFilePrint(struct WavFile *wavFile) {
-    setTextColor(WHITE, RED);
-    print("Channels: ");
-    restoreColours();
-    printNumber(wavFile->info.numberOfChannels);
-
-    setTextColor(WHITE, RED);
-    print("Sample rate: ");
-    restoreColours();
-    printNumber(wavFile->info.sampleRate);
-
-    setTextColor(WHITE, RED);
-    print("Bits per sample: ");
-    restoreColours();
-    printNumber(wavFile->info.bitsPerSample);
+struct WavFile *wavFileLoad(FIL *file, struct Arena *arena) {
+    struct RiffChunkHeader header;
+    char riffType[4];
+    if (!readExactly(file, &header, sizeof(header)) || memcmp(header.id, "RIFF", 4) != 0
+        || !readExactly(file, riffType, sizeof(riffType)) || memcmp(riffType, "WAVE", 4) != 0) {
+        return NULL;
+    }
+
+    struct WavFile *result = arenaAllocate(arena, sizeof(struct WavFile));
+    if (result == NULL) {
+        return NULL;
+    }
+    bool formatFound = false;
+    // Single pass over chunks, bodies of unknown ones are skipped without reading.
+    while (readExactly(file, &header, sizeof(header))) {
+        if (memcmp(header.id, "fmt ", 4) == 0 && header.size >= sizeof(result->info)) {
+            if (!readExactly(file, &result->info, sizeof(result->info))) {
+                break;
+            }
+            formatFound = true;
+            if (!skipChunk(file, header.size - sizeof(result->info))) {
+                break;
+            }
+        }
+        else if (memcmp(header.id, "data", 4) == 0) {
+            if (!formatFound) {
+                break;
+            }
+            result->dataOffset = f_tell(file);
+            FSIZE_t available = f_size(file) - result->dataOffset;
+            result->dataSize = header.size < available ? header.size : available; // Truncated files.
+            result->file = file;
+            return result;
+        }
+        else if (!skipChunk(file, header.size)) {
+            break;
+        }
+    }
+    return NULL;
 }
 
 inline void wavFileDestroy(struct WavFile *wavFile) {
     if (wavFile != NULL) {
         f_close(wavFile->file);
-        free(wavFile->file);
-        free(wavFile);
     }
 }
 
@@ -113,6 +128,26 @@ inline uint16_t wavFileBitsPerSample(struct WavFile *wavFile) {
     return wavFile->info.bitsPerSample;
 }
 
+inline FSIZE_t wavFileDataOffset(struct WavFile *wavFile) {
+    return wavFile->dataOffset;
+}
+
+inline uint32_t wavFileDataSize(struct WavFile *wavFile) {
+    return wavFile->dataSize;
+}
+
+inline uint32_t wavFileByteRate(struct WavFile *wavFile) {
+    return wavFile->info.byteRate;
+}
+
+inline uint16_t wavFileFormatTag(struct WavFile *wavFile) {
+    return wavFile->info.formatTag;
+}
+
+inline uint16_t wavFileBlockAlign(struct WavFile *wavFile) {
+    return wavFile->info.blockAlign;
+}
+
 inline FIL *wavFileGetFile(struct WavFile *wavFile) {
     return wavFile->file;
 }
\ No newline at end of file
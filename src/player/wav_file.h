@@ -9,10 +9,37 @@
 #ifndef __WAV_FILE_H__
 #define __WAV_FILE_H__
 
-#include <avr/io.h>
+#include "../hal/platform.h"
 #include <stdlib.h>
 #include <assert.h>
 #include "../lib/fat-fs/ff.h"
+#include "../memory/arena.h"
+#include "../memory/ram_budget.h"
+
+/**
+ * @brief Format tag of uncompressed samples.
+ */
+#define WAV_FORMAT_PCM 1
+
+/**
+ * @brief Format tag of G.711 A-law companded samples.
+ */
+#define WAV_FORMAT_ALAW 6
+
+/**
+ * @brief Format tag of G.711 mu-law companded samples.
+ */
+#define WAV_FORMAT_MULAW 7
+
+/**
+ * @brief Format tag of IMA ADPCM compressed samples.
+ */
+#define WAV_FORMAT_IMA_ADPCM 0x11
+
+/**
+ * @brief Arena bytes taken by @ref WavFile.
+ */
+#define WAV_FILE_RAM_BUDGET (28 * RAM_BUDGET_SCALE)
 
 /**
  * @brief Representation of wav file properties and data.
@@ -20,18 +47,26 @@
 struct WavFile;
 
 /**
- * @brief Initialize @ref WavFile.
- * @param[in] file : Pointer to file, which will be loaded.
- * @return Pointer to a newly created wav file.
+ * @brief Initialize @ref WavFile, by walking RIFF chunks to the @p data one.
+ * @param[in] file : Pointer to file, which will be loaded, it is owned by wav file on success.
+ * @param[out] arena : Arena, from which wav file is allocated, it is released with the arena, also on failure.
+ * @return Pointer to a newly created wav file, @p NULL if @p file is not a valid wav file.
  */
-struct WavFile *wavFileLoad(FIL *file);
+struct WavFile *wavFileLoad(FIL *file, struct Arena *arena);
 
 /**
- * @brief Destroy @ref WavFile.
+ * @brief Destroy @ref WavFile, closing its file, memory of both is released with their arena.
  * @param[out] wavFile : Pointer to structure, which will be destroyed.
  */
 void wavFileDestroy(struct WavFile *wavFile);
 
+/**
+ * @brief Get format tag.
+ * @param[in] wavFile : Pointer to wav file.
+ * @return Encoding of samples, e.g. @ref WAV_FORMAT_PCM.
+ */
+uint16_t wavFileFormatTag(struct WavFile *wavFile);
+
 /**
  * @brief Get number of channels.
  * @param[in] wavFile : Pointer to wav file.
@@ -53,6 +88,13 @@ uint32_t wavFileSampleRate(struct WavFile *wavFile);
  */
 uint16_t wavFileBitsPerSample(struct WavFile *wavFile);
 
+/**
+ * @brief Get block align.
+ * @param[in] wavFile : Pointer to wav file.
+ * @return Size in bytes of the smallest unit of raw data, which can be decoded.
+ */
+uint16_t wavFileBlockAlign(struct WavFile *wavFile);
+
 /**
  * @brief Get raw data size.
  * @param[in] wavFile : Pointer to wav file.
@@ -61,16 +103,24 @@ uint16_t wavFileBitsPerSample(struct WavFile *wavFile);
 uint32_t wavFileDataSize(struct WavFile *wavFile);
 
 /**
- * @brief Get file represented by @p wavFile.
+ * @brief Get offset of raw data.
  * @param[in] wavFile : Pointer to wav file.
- * @return File represented by @p wavFile.
+ * @return File offset in bytes of the first sample.
  */
-FIL* wavFileGetFile(struct WavFile *wavFile);
+FSIZE_t wavFileDataOffset(struct WavFile *wavFile);
+
+/**
+ * @brief Get number of raw data bytes per second.
+ * @param[in] wavFile : Pointer to wav file.
+ * @return Byte rate derived from wav file properties.
+ */
+uint32_t wavFileByteRate(struct WavFile *wavFile);
 
 /**
- * @brief Print wav file properties.
+ * @brief Get file represented by @p wavFile.
  * @param[in] wavFile : Pointer to wav file.
+ * @return File represented by @p wavFile.
  */
-void wavFilePrint(struct WavFile *wavFile);
+FIL* wavFileGetFile(struct WavFile *wavFile);
 
 #endif /* __WAV_FILE_H__ */
@@ -6,22 +6,91 @@
  * @date 12.06.2018
  */
 
-#include <stdlib.h>
-#include <avr/interrupt.h>
+#include <stddef.h>
 #include "wav_player.h"
 #include "wav_file.h"
-#include "fifo_buffer.h"
+#include "playback_buffer.h"
+#include "sector_source.h"
+#include "sample_decoder.h"
+#include "audio_output.h"
+#include "../hal/timers.h"
+#include "../memory/pool.h"
+
+/**
+ * @brief Number of seconds before the end of a song, when the next one starts to be prepared in play next mode.
+ */
+#define PREFETCH_SECONDS 2
+
+/**
+ * @brief Steps of preparing the next song, each one done by a separate refill task run.
+ */
+enum PrefetchState {
+    PREFETCH_IDLE, ///< Nothing prepared yet.
+    PREFETCH_FOUND, ///< Directory entry of the next song is found.
+    PREFETCH_OPENED, ///< File of the next song is opened.
+    PREFETCH_LOADED, ///< Header of the next song is parsed and its decoder initialized.
+    PREFETCH_MAPPING, ///< Source of the next song is created, its link map is being built.
+    PREFETCH_READY, ///< Source of the next song is complete, it can be spliced.
+    PREFETCH_NONE ///< There is no next song, which could be spliced.
+};
+
+/**
+ * @brief Memory of a song: its file, wav file and sector source, released together.
+ */
+struct Track {
+    struct Arena arena; ///< Allocator of song objects from @ref memory.
+    _Alignas(ARENA_ALIGNMENT) uint8_t memory[WAV_PLAYER_TRACK_RAM_BUDGET]; ///< Storage of song objects.
+};
+
+/**
+ * @brief Next song prepared in play next mode, while the current one is still playing.
+ */
+struct Prefetch {
+    enum PrefetchState state; ///< Prepared parts.
+    struct Track *track; ///< Memory of the next song, valid from @ref PREFETCH_OPENED.
+    FIL *file; ///< File of the next song, valid from @ref PREFETCH_OPENED.
+    struct WavFile *wavFile; ///< Loaded next song, valid from @ref PREFETCH_LOADED.
+    struct SampleDecoder decoder; ///< Decoder of the next song, valid from @ref PREFETCH_LOADED.
+    struct SectorSource *source; ///< Source of the next song sectors, valid from @ref PREFETCH_MAPPING.
+    struct ViewSelection selection; ///< Directory entry of the next song, valid from @ref PREFETCH_FOUND.
+};
 
 /**
  * @brief Wav player state structure.
  */
 struct WavPlayer {
+    struct Track *track; ///< Memory of @ref wavFile, its file and @ref source.
     struct WavFile *wavFile; ///< Loaded wav file.
-    struct FifoBuffer *buffer; ///< Internal buffer, used by loading and playing interrupts.
+    struct SectorSource *source; ///< Source of @ref wavFile sectors.
+    struct PlaybackBuffer *buffer; ///< Internal buffer, used by refill task and output interrupt.
     struct View *view; ///< Display view.
+    uint32_t outputRate; ///< Sample rate of the output.
     bool paused; ///< Flag indicating if is paused.
+    struct Prefetch next; ///< Next song prepared in play next mode.
 };
 
+RAM_BUDGET_CHECK(sizeof(struct WavPlayer), WAV_PLAYER_RAM_BUDGET);
+
+/**
+ * @brief Storage of the only wav player, there is nothing to play simultaneously.
+ */
+static struct WavPlayer playerObjects[1];
+
+/**
+ * @brief Pool of @ref playerObjects.
+ */
+static struct Pool players = POOL_INITIALIZER(playerObjects);
+
+/**
+ * @brief Storage of tracks, the playing one and the next one prepared in play next mode.
+ */
+static struct Track trackObjects[WAV_PLAYER_TRACKS];
+
+/**
+ * @brief Pool of @ref trackObjects.
+ */
+static struct Pool tracks = POOL_INITIALIZER(trackObjects);
+
 /**
  * @brief Pointer to currently playing wav player - shared state.
  */
@@ -30,57 +99,244 @@ static struct WavPlayer *currentlyPlaying;
 /**
  * @brief Field @ref WavPlayer.buffer of @ref currentlyPlaying, exists because of performance reasons.
  */
-static struct FifoBuffer *currentlyPlayingFifoBuffer;
+static struct PlaybackBuffer *currentlyPlayingBuffer;
+
+/**
+ * @brief Flag set, when currently playing song reached its end.
+ */
+static bool finished;
 
 /**
- * @brief Field @ref FifoBuffer.buffer of @ref currentlyPlayingFifoBuffer, exists because of performance reasons.
+ * @brief Flag set, when currently playing wav player continued with the next song.
  */
-static uint8_t *currentlyPlayingBuffer;
+static bool trackChanged;
 
 /**
- * @brief DAC output port.
+ * @brief Flag indicating if songs are followed by the next ones in their directory.
  */
-#define OUTPUT_PORT PORTD
+static bool playNext;
 
 /**
- * @brief DAC output interrupt.
+ * @brief Telemetry of the last stopped song.
  */
-ISR(TIMER1_COMPA_vect) {
-    OUTPUT_PORT = currentlyPlayingBuffer[currentlyPlayingFifoBuffer->currentReadPosition++];
+static struct PlaybackStats lastStats;
+
+/**
+ * @brief Lowest sample rate, for which output timer period fits in 16 bits.
+ */
+#define MINIMUM_SAMPLE_RATE (F_CPU / UINT16_MAX + 1)
+
+/**
+ * @brief Highest sample rate, for which resampler step down to @ref WAV_PLAYER_OUTPUT_RATE fits in 16 bits.
+ */
+#define MAXIMUM_SAMPLE_RATE (UINT16_MAX * WAV_PLAYER_OUTPUT_RATE / RESAMPLER_UNITY)
+
+#ifdef WAV_PLAYER_NAKED_ISR
+/**
+ * @brief Switch playing buffer to the next half, called by the naked output interrupt.
+ */
+static void outputNextHalf() {
+    bufferNextHalf(currentlyPlayingBuffer);
 }
 
 /**
- * @brief File loading interrupt.
+ * @brief Sample clock interrupt, feeding the audio output backend.
+ * Read pointers stay in the buffer, loaded to X through Z, so only those, SREG and the sample are pushed.
+ * Call-clobbered registers are saved only at the end of a half.
  */
-ISR(TIMER0_COMP_vect, ISR_BLOCK) {
-    if (bufferCurrentSize(currentlyPlaying->buffer) <= FIFO_BUFFER_SIZE / 2) {
-        fileRefillBuffer(wavFileGetFile(currentlyPlaying->wavFile), currentlyPlayingFifoBuffer);
-        if (f_eof(wavFileGetFile(currentlyPlaying->wavFile))) {
-            viewStopped(currentlyPlaying->view);
-            wavPlayerStopPlaying();
-        }
+_Static_assert(offsetof(struct PlaybackBuffer, readPosition) == 0, "naked output interrupt reads buffer through Z");
+ISR(TIMER1_COMPA_vect, ISR_NAKED) {
+    asm volatile(
+            "push r24" "\n\t"
+            "in r24, __SREG__" "\n\t"
+            "push r24" "\n\t"
+            "push r26" "\n\t"
+            "push r27" "\n\t"
+            "push r30" "\n\t"
+            "push r31" "\n\t"
+            "lds r30, %[buffer]" "\n\t"
+            "lds r31, %[buffer]+1" "\n\t"
+            "ld r26, Z" "\n\t"
+            "ldd r27, Z+1" "\n\t"
+            "ldd r24, Z+%[end]" "\n\t"
+            "cp r26, r24" "\n\t"
+            "ldd r24, Z+%[end]+1" "\n\t"
+            "cpc r27, r24" "\n\t"
+            "brne 1f" "\n\t"
+            "push r0" "\n\t"
+            "push r1" "\n\t"
+            "clr r1" "\n\t"
+            "push r18" "\n\t"
+            "push r19" "\n\t"
+            "push r20" "\n\t"
+            "push r21" "\n\t"
+            "push r22" "\n\t"
+            "push r23" "\n\t"
+            "push r25" "\n\t"
+            "call %x[nextHalf]" "\n\t"
+            "pop r25" "\n\t"
+            "pop r23" "\n\t"
+            "pop r22" "\n\t"
+            "pop r21" "\n\t"
+            "pop r20" "\n\t"
+            "pop r19" "\n\t"
+            "pop r18" "\n\t"
+            "pop r1" "\n\t"
+            "pop r0" "\n\t"
+            "lds r30, %[buffer]" "\n\t"
+            "lds r31, %[buffer]+1" "\n\t"
+            "ld r26, Z" "\n\t"
+            "ldd r27, Z+1" "\n\t"
+            "1:" "\n\t"
+            "ld r24, X+" "\n\t"
+            "st Z, r26" "\n\t"
+            "std Z+1, r27" "\n\t"
+            "out %[output], r24" "\n\t"
+            "pop r31" "\n\t"
+            "pop r30" "\n\t"
+            "pop r27" "\n\t"
+            "pop r26" "\n\t"
+            "pop r24" "\n\t"
+            "out __SREG__, r24" "\n\t"
+            "pop r24" "\n\t"
+            "reti" "\n\t"
+            :: [buffer] "i" (&currentlyPlayingBuffer), [end] "I" (offsetof(struct PlaybackBuffer, readEnd)),
+               [nextHalf] "i" (outputNextHalf), [output] "I" (_SFR_IO_ADDR(AUDIO_OUTPUT_REGISTER)));
+}
+#else
+/**
+ * @brief Sample clock interrupt, feeding the audio output backend.
+ */
+TIMERS_SAMPLE_CLOCK_INTERRUPT {
+    struct PlaybackBuffer *buffer = currentlyPlayingBuffer;
+    if (buffer->readPosition == buffer->readEnd) {
+        bufferNextHalf(buffer);
     }
+    audioOutputWrite(*buffer->readPosition++);
+}
+#endif /* WAV_PLAYER_NAKED_ISR */
+
+/**
+ * @brief Get sample rate of the output for a song.
+ * @param[in] sampleRate : Sample rate of the song.
+ * @return Output rate, songs faster than @ref WAV_PLAYER_OUTPUT_RATE are resampled down to it.
+ */
+static inline uint32_t outputRateOf(uint32_t sampleRate) {
+    return sampleRate < WAV_PLAYER_OUTPUT_RATE ? sampleRate : WAV_PLAYER_OUTPUT_RATE;
+}
+
+/**
+ * @brief Initialize decoder of a loaded wav file.
+ * @param[out] decoder : Decoder to initialize.
+ * @param[in] wavFile : Loaded wav file.
+ * @return @p true if the song can be played, @p false otherwise.
+ */
+static bool wavFileDecoderInit(struct SampleDecoder *decoder, struct WavFile *wavFile) {
+    bool supported = sampleDecoderInit(decoder, wavFileFormatTag(wavFile), wavFileBitsPerSample(wavFile),
+                                       wavFileNumberOfChannels(wavFile), wavFileBlockAlign(wavFile));
+    uint32_t sampleRate = wavFileSampleRate(wavFile);
+    return supported && sampleRate >= MINIMUM_SAMPLE_RATE && sampleRate <= MAXIMUM_SAMPLE_RATE;
+}
+
+/**
+ * @brief Take a track and open a song file in it.
+ * Track arena is sized for all song objects, so their allocations never fail afterwards.
+ * @param[in] path : Path of the song file.
+ * @param[out] file : Opened file, allocated from the track.
+ * @return Pointer to the track, @p NULL if file could not be opened, or no track is free.
+ */
+static struct Track *trackOpen(const char *path, FIL **file) {
+    struct Track *result = poolTake(&tracks);
+    if (result == NULL) {
+        return NULL;
+    }
+    arenaInit(&result->arena, result->memory, sizeof(result->memory));
+    *file = arenaAllocate(&result->arena, sizeof(FIL));
+    if (f_open(*file, path, FA_READ) != FR_OK) {
+        poolGive(&tracks, result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * @brief Give track back, its objects have to be destroyed already.
+ * @param[out] track : Pointer to the track.
+ */
+static inline void trackRelease(struct Track *track) {
+    poolGive(&tracks, track);
 }
 
-struct WavPlayer *wavPlayerInit(FIL *file, struct View *view) {
-    struct WavPlayer *result = malloc(sizeof(struct WavPlayer));
-    result->wavFile = wavFileLoad(file);
-    result->buffer = bufferInit();
+struct WavPlayer *wavPlayerInit(const char *path, struct View *view) {
+    struct WavPlayer *result = poolTake(&players);
+    if (result == NULL) {
+        return NULL;
+    }
+    FIL *file;
+    struct Track *track = trackOpen(path, &file);
+    if (track == NULL) {
+        poolGive(&players, result);
+        return NULL;
+    }
+    struct WavFile *wavFile = wavFileLoad(file, &track->arena);
+    struct SampleDecoder decoder;
+    if (wavFile == NULL || !wavFileDecoderInit(&decoder, wavFile)) {
+        f_close(file);
+        trackRelease(track);
+        poolGive(&players, result);
+        return NULL;
+    }
+    uint32_t sampleRate = wavFileSampleRate(wavFile);
+
+    result->track = track;
+    result->wavFile = wavFile;
+    result->outputRate = outputRateOf(sampleRate);
+    result->source = sectorSourceInit(file, wavFileDataOffset(wavFile) + wavFileDataSize(wavFile), &track->arena);
+    // Nothing plays yet, so the whole link map is built at once.
+    while (!sectorSourceMapStep(result->source)) {
+    }
+    // Taken and given back along with the only player, so it is always free here.
+    result->buffer = bufferInit(&decoder, sampleRate, result->outputRate);
+    bufferSeek(result->buffer, result->source, wavFileDataOffset(result->wavFile));
     result->view = view;
     result->paused = false;
+    result->next.state = PREFETCH_IDLE;
     return result;
 }
 
+/**
+ * @brief Release prepared parts of the next song.
+ * @param[out] next : Next song to release.
+ */
+static void prefetchDiscard(struct Prefetch *next) {
+    if (next->state == PREFETCH_MAPPING || next->state == PREFETCH_READY) {
+        sectorSourceDestroy(next->source);
+    }
+    if (next->state == PREFETCH_LOADED || next->state == PREFETCH_MAPPING || next->state == PREFETCH_READY) {
+        wavFileDestroy(next->wavFile);
+    }
+    else if (next->state == PREFETCH_OPENED) {
+        f_close(next->file);
+    }
+    if (next->state != PREFETCH_IDLE && next->state != PREFETCH_FOUND && next->state != PREFETCH_NONE) {
+        trackRelease(next->track);
+    }
+    next->state = PREFETCH_IDLE;
+}
+
 void wavPlayerDestroy(struct WavPlayer *player) {
     if (player != NULL) {
+        prefetchDiscard(&player->next);
+        sectorSourceDestroy(player->source);
         wavFileDestroy(player->wavFile);
+        trackRelease(player->track);
         bufferDestroy(player->buffer);
-        free(player);
+        poolGive(&players, player);
     }
 }
 
 void wavPlayerPausePlaying() {
-    cli();
+    timersSampleInterruptDisable();
     if (currentlyPlaying) {
         currentlyPlaying->paused = true;
     }
@@ -89,45 +345,203 @@ void wavPlayerPausePlaying() {
 void wavPlayerStopPlaying() {
     wavPlayerPausePlaying();
 
-    TCCR1B = 0;
-    TCCR0 = 0;
-    TIMSK = 0;
+    timersSampleClockStop();
 
+    if (currentlyPlaying) {
+        lastStats = *bufferStats(currentlyPlaying->buffer);
+    }
     wavPlayerDestroy(currentlyPlaying);
     currentlyPlaying = NULL;
     currentlyPlayingBuffer = NULL;
-    currentlyPlayingFifoBuffer = NULL;
 }
 
 void wavPlayerStartPlaying(struct WavPlayer *player) {
     wavPlayerPausePlaying();
 
     currentlyPlaying = player;
-    currentlyPlayingFifoBuffer = player->buffer;
-    currentlyPlayingBuffer = player->buffer->buffer;
+    currentlyPlayingBuffer = player->buffer;
+    sourceRefillBuffer(player->source, player->buffer);
 
-    // Configure playing timer
-    TCCR1B = 1 << CS10 | 1 << WGM12; // NOLINT
-    OCR1A = (uint16_t) (F_CPU / wavFileSampleRate(player->wavFile) - 1);
-    TIMSK |= 1 << OCIE1A; // NOLINT
+    // Rounded to the nearest period, songs slower than the output rate are played at their own rate.
+    timersSampleClockStart((uint16_t) ((F_CPU + player->outputRate / 2) / player->outputRate));
+    player->paused = false;
+    timersSampleInterruptEnable();
+}
 
-    // Configure player file reading timer
-    TCCR0 = 1 << CS00 | 1 << CS01 | 1 << WGM01; // NOLINT
-    OCR0 = (uint8_t) ((F_CPU / wavFileSampleRate(player->wavFile) - 1) / 5);
-    TIMSK |= 1 << OCIE0; // NOLINT
+uint32_t wavPlayerGetPosition(struct WavPlayer *player) {
+    return bufferPosition(player->buffer) - wavFileDataOffset(player->wavFile);
+}
 
-    sei();
-    player->paused = false;
+void wavPlayerSeek(struct WavPlayer *player, uint32_t position) {
+    uint32_t dataSize = wavFileDataSize(player->wavFile);
+    if (position > dataSize) {
+        position = dataSize;
+    }
+    // Decoders need whole frames, or whole blocks of compressed formats.
+    position -= position % wavFileBlockAlign(player->wavFile);
+    // Output plays silence until the refill task reads the new position, no need to stop it.
+    bufferSeek(player->buffer, player->source, wavFileDataOffset(player->wavFile) + position);
+}
+
+void wavPlayerFastForward(struct WavPlayer *player) {
+    wavPlayerSeek(player, wavPlayerGetPosition(player) + WAV_PLAYER_SEEK_STEP_SECONDS * wavFileByteRate(player->wavFile));
+}
+
+void wavPlayerRewind(struct WavPlayer *player) {
+    uint32_t step = WAV_PLAYER_SEEK_STEP_SECONDS * wavFileByteRate(player->wavFile);
+    uint32_t position = wavPlayerGetPosition(player);
+    wavPlayerSeek(player, position > step ? position - step : 0);
+}
+
+/**
+ * @brief Do a single step of preparing the next song, once the current one is close to its end.
+ * A step is a lookup of the next entry or of the opened path in the directory, the song header,
+ * or a FAT sector worth of the cluster chain. It is done only when the buffer is full, or there is nothing to refill,
+ * which leaves it the playback time of a full half.
+ * @param[out] player : Pointer to currently playing wav player.
+ */
+static void prefetchStep(struct WavPlayer *player) {
+    struct Prefetch *next = &player->next;
+    if (!sectorSourceEof(player->source) && !bufferIsFull(player->buffer)) {
+        return;
+    }
+
+    switch (next->state) {
+        case PREFETCH_IDLE: {
+            uint32_t left = wavFileDataSize(player->wavFile) - wavPlayerGetPosition(player);
+            if (!sectorSourceEof(player->source) && left > PREFETCH_SECONDS * wavFileByteRate(player->wavFile)) {
+                return;
+            }
+            next->state = viewGetNextSong(player->view, &next->selection) ? PREFETCH_FOUND : PREFETCH_NONE;
+            break;
+        }
+        case PREFETCH_FOUND: {
+            char path[VIEW_PATH_SIZE];
+            viewGetSelectionPath(player->view, &next->selection, path);
+            next->track = trackOpen(path, &next->file);
+            next->state = next->track != NULL ? PREFETCH_OPENED : PREFETCH_NONE;
+            break;
+        }
+        case PREFETCH_OPENED:
+            next->wavFile = wavFileLoad(next->file, &next->track->arena);
+            if (next->wavFile == NULL) {
+                prefetchDiscard(next);
+                next->state = PREFETCH_NONE;
+                break;
+            }
+            next->state = PREFETCH_LOADED;
+            // Splicing keeps the output timer running, so only songs played at the same rate follow.
+            if (!wavFileDecoderInit(&next->decoder, next->wavFile)
+                || outputRateOf(wavFileSampleRate(next->wavFile)) != player->outputRate) {
+                prefetchDiscard(next);
+                next->state = PREFETCH_NONE;
+            }
+            break;
+        case PREFETCH_LOADED:
+            next->source = sectorSourceInit(next->file,
+                                            wavFileDataOffset(next->wavFile) + wavFileDataSize(next->wavFile),
+                                            &next->track->arena);
+            next->state = PREFETCH_MAPPING;
+            break;
+        case PREFETCH_MAPPING:
+            if (sectorSourceMapStep(next->source)) {
+                next->state = PREFETCH_READY;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Continue refilling from the prepared next song, replacing the current one.
+ * @param[out] player : Pointer to currently playing wav player.
+ */
+static void prefetchSplice(struct WavPlayer *player) {
+    struct Prefetch *next = &player->next;
+    sectorSourceDestroy(player->source);
+    wavFileDestroy(player->wavFile);
+    trackRelease(player->track);
+    player->track = next->track;
+    player->wavFile = next->wavFile;
+    player->source = next->source;
+    bufferSplice(player->buffer, player->source, &next->decoder, wavFileSampleRate(player->wavFile),
+                 player->outputRate, wavFileDataOffset(player->wavFile));
+    viewSelect(player->view, &next->selection);
+    next->state = PREFETCH_IDLE;
+    trackChanged = true;
+}
+
+void wavPlayerRefill(void *context) {
+    (void) context;
+    if (!wavPlayerIsPlaying()) {
+        return;
+    }
+    sourceRefillBuffer(currentlyPlaying->source, currentlyPlayingBuffer);
+    bool endOfSong = sectorSourceEof(currentlyPlaying->source);
+    if (playNext) {
+        prefetchStep(currentlyPlaying);
+        if (endOfSong && currentlyPlaying->next.state == PREFETCH_READY) {
+            prefetchSplice(currentlyPlaying);
+            return;
+        }
+        if (endOfSong && currentlyPlaying->next.state != PREFETCH_NONE) {
+            return; // Next song is still being prepared, silence is played if the buffer runs out meanwhile.
+        }
+    }
+    if (endOfSong && bufferIsEmpty(currentlyPlayingBuffer)) {
+        wavPlayerStopPlaying();
+        finished = true;
+    }
+}
+
+bool wavPlayerTakeFinished() {
+    bool result = finished;
+    finished = false;
+    return result;
+}
+
+bool wavPlayerTakeTrackChanged() {
+    bool result = trackChanged;
+    trackChanged = false;
+    return result;
+}
+
+void wavPlayerSetPlayNext(bool enabled) {
+    playNext = enabled;
+}
+
+bool wavPlayerIsPlayNext() {
+    return playNext;
 }
 
 bool wavPlayerIsPlaying() {
     return currentlyPlaying != NULL && !currentlyPlaying->paused;
 }
 
+uint32_t wavPlayerDrawingBudget(uint32_t minimum) {
+    if (!wavPlayerIsPlaying()) {
+        return UINT32_MAX;
+    }
+    // Drawing holds refills off, so it goes on only while there is nothing to refill, until a half is played.
+    bool refilling = !sectorSourceEof(currentlyPlaying->source);
+    struct PlaybackBuffer *buffer = currentlyPlayingBuffer;
+    if (refilling && !bufferIsFull(buffer)) {
+        return 0;
+    }
+    uint16_t samples = refilling ? bufferPlayingSize(buffer) : bufferCurrentSize(buffer);
+    uint32_t result = (uint32_t) samples * (F_CPU / currentlyPlaying->outputRate);
+    return result > minimum ? result : minimum;
+}
+
 struct WavPlayer *wavPlayerGetCurrentlyPlaying() {
     return currentlyPlaying;
 }
 
 struct WavFile *wavPlayerGetWavFile(const struct WavPlayer *player) {
     return player->wavFile;
-}
\ No newline at end of file
+}
+
+const struct PlaybackStats *wavPlayerGetStats() {
+    return currentlyPlaying != NULL ? bufferStats(currentlyPlaying->buffer) : &lastStats;
+}
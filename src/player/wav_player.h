@@ -12,6 +12,44 @@
 #include <stdbool.h>
 #include "../view/view.h"
 #include "../lib/fat-fs/ff.h"
+#include "playback_buffer.h"
+#include "sector_source.h"
+#include "wav_file.h"
+#include "../memory/arena.h"
+#include "../memory/ram_budget.h"
+
+/**
+ * @brief Length of a fast forward or rewind jump.
+ */
+#define WAV_PLAYER_SEEK_STEP_SECONDS 5
+
+/**
+ * @brief Highest sample rate of the output, faster songs are resampled down to it while refilling.
+ * Divides @p F_CPU, leaving 500 cycles per sample at 8 MHz for the output interrupt, refill and user interface.
+ */
+#define WAV_PLAYER_OUTPUT_RATE 16000UL
+
+/**
+ * @brief Number of songs held at once, the playing one and the next one prepared in play next mode.
+ */
+#define WAV_PLAYER_TRACKS 2
+
+/**
+ * @brief Arena bytes of a single song: its file, wav file and sector source.
+ */
+#define WAV_PLAYER_TRACK_RAM_BUDGET \
+    (ARENA_ALIGN(sizeof(FIL)) + ARENA_ALIGN(WAV_FILE_RAM_BUDGET) + ARENA_ALIGN(SECTOR_SOURCE_RAM_BUDGET))
+
+/**
+ * @brief Bytes of @ref WavPlayer, without its songs and playback buffer.
+ */
+#define WAV_PLAYER_RAM_BUDGET (80 * RAM_BUDGET_SCALE)
+
+/**
+ * @brief Statically allocated bytes of the player module: wav player, its songs and playback buffer.
+ */
+#define WAV_PLAYER_TOTAL_RAM_BUDGET (WAV_PLAYER_RAM_BUDGET + sizeof(struct PlaybackBuffer) \
+    + WAV_PLAYER_TRACKS * (sizeof(struct Arena) + WAV_PLAYER_TRACK_RAM_BUDGET))
 
 /**
  * @brief Wav player state structure.
@@ -19,12 +57,13 @@
 struct WavPlayer;
 
 /**
- * @brief Initialize @ref WavPlayer.
- * @param[in] file : Pointer to file to be played.
+ * @brief Initialize @ref WavPlayer, taking the only one from its pool.
+ * @param[in] path : Path of a file to be played.
  * @param[in] view : Pointer to a screen managing view.
- * @return Pointer to newly created @ref WavPlayer.
+ * @return Pointer to newly created @ref WavPlayer, @p NULL if file is not a supported wav file,
+ * or a wav player exists already.
  */
-struct WavPlayer *wavPlayerInit(FIL *file, struct View *view);
+struct WavPlayer *wavPlayerInit(const char *path, struct View *view);
 
 /**
  * @brief Destroy @ref WavPlayer.
@@ -48,6 +87,66 @@ void wavPlayerStopPlaying();
  */
 void wavPlayerPausePlaying();
 
+/**
+ * @brief Get playing position.
+ * @param[in] player : Pointer to a wav player structure.
+ * @return Offset of the sample played now, in bytes from the beginning of raw data.
+ */
+uint32_t wavPlayerGetPosition(struct WavPlayer *player);
+
+/**
+ * @brief Jump to a position, playing continues from there after a single sector read.
+ * @param[out] player : Pointer to a wav player structure.
+ * @param[in] position : Offset in bytes from the beginning of raw data, clipped to data size.
+ */
+void wavPlayerSeek(struct WavPlayer *player, uint32_t position);
+
+/**
+ * @brief Jump @ref WAV_PLAYER_SEEK_STEP_SECONDS forward.
+ * @param[out] player : Pointer to a wav player structure.
+ */
+void wavPlayerFastForward(struct WavPlayer *player);
+
+/**
+ * @brief Jump @ref WAV_PLAYER_SEEK_STEP_SECONDS backward.
+ * @param[out] player : Pointer to a wav player structure.
+ */
+void wavPlayerRewind(struct WavPlayer *player);
+
+/**
+ * @brief Refill buffer of currently playing wav player, stop it at the end of a song.
+ * In play next mode, the next song in directory is prepared meanwhile and its data follows in the same buffer,
+ * if it is played at the same output rate.
+ * Scheduler task, must be run often enough to refill a buffer half before it is played.
+ * @param[in] context : Unused.
+ */
+void wavPlayerRefill(void *context);
+
+/**
+ * @brief Check if song ended since the last call, and clear this information.
+ * @return @p true if song ended, @p false otherwise.
+ */
+bool wavPlayerTakeFinished();
+
+/**
+ * @brief Check if currently playing wav player continued with the next song since the last call,
+ * and clear this information. View selection is moved to that song already.
+ * @return @p true if song changed, @p false otherwise.
+ */
+bool wavPlayerTakeTrackChanged();
+
+/**
+ * @brief Enable or disable play next mode, in which songs are followed by the next ones in their directory.
+ * @param[in] enabled : @p true to enable, @p false to disable.
+ */
+void wavPlayerSetPlayNext(bool enabled);
+
+/**
+ * @brief Check if play next mode is enabled.
+ * @return @p true if it is, @p false otherwise.
+ */
+bool wavPlayerIsPlayNext();
+
 /**
  * @brief Check if any wav player is running.
  * @return @p true if it is, @p false otherwise.
@@ -67,4 +166,19 @@ struct WavFile *wavPlayerGetWavFile(const struct WavPlayer *player);
  */
 struct WavPlayer *wavPlayerGetCurrentlyPlaying();
 
+/**
+ * @brief Get number of CPU cycles, which can be spent e.g. drawing screen without holding off a refill.
+ * Buffer waiting for a refill gets none, full one gets the rest of the playing half, but at least @p minimum,
+ * so songs holding few samples per half do not starve the caller. Refilled half covers @p minimum then.
+ * @param[in] minimum : Number of cycles granted while there is nothing to refill.
+ * @return Number of cycles, @p UINT32_MAX if nothing is playing.
+ */
+uint32_t wavPlayerDrawingBudget(uint32_t minimum);
+
+/**
+ * @brief Get playback telemetry.
+ * @return Counters of currently playing song, or of the last stopped one if nothing is playing.
+ */
+const struct PlaybackStats *wavPlayerGetStats();
+
 #endif /* __WAV_PLAYER_H__ */
@@ -0,0 +1,124 @@
+/**
+ * @file
+ * Cooperative task scheduler implementation.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include <stddef.h>
+#include "scheduler.h"
+#include "../hal/timers.h"
+#include "../memory/pool.h"
+
+/**
+ * @brief Single task entry.
+ */
+struct SchedulerEntry {
+    SchedulerTask task; ///< Task body.
+    void *context; ///< Argument passed to task body.
+    uint16_t period; ///< Ticks between consecutive deadlines.
+    uint16_t deadline; ///< Tick, at which task should be run.
+};
+
+/**
+ * @brief Cooperative scheduler state structure.
+ */
+struct Scheduler {
+    struct SchedulerEntry entries[SCHEDULER_MAX_TASKS]; ///< Registered tasks.
+    uint8_t numberOfEntries; ///< Number of registered tasks.
+    volatile bool running; ///< Flag indicating if scheduler is running.
+};
+
+RAM_BUDGET_CHECK(sizeof(struct Scheduler), SCHEDULER_RAM_BUDGET);
+
+/**
+ * @brief Storage of the only scheduler, there is a single clock timer.
+ */
+static struct Scheduler schedulerObjects[1];
+
+/**
+ * @brief Pool of @ref schedulerObjects.
+ */
+static struct Pool schedulers = POOL_INITIALIZER(schedulerObjects);
+
+/**
+ * @brief Check if @p tick is earlier than @p other, taking clock wrap around into account.
+ * @param[in] tick : one tick of the examined pair.
+ * @param[in] other : one tick of the examined pair.
+ * @return @p true if @p tick is earlier, @p false otherwise.
+ */
+static inline bool isBefore(uint16_t tick, uint16_t other) {
+    return (int16_t) (tick - other) < 0;
+}
+
+struct Scheduler *schedulerInit() {
+    struct Scheduler *result = poolTake(&schedulers);
+    if (result == NULL) {
+        return NULL;
+    }
+
+    timersTickStart(SCHEDULER_TICKS_PER_SECOND);
+    timersInterruptsEnable();
+    return result;
+}
+
+void schedulerDestroy(struct Scheduler *scheduler) {
+    timersTickStop();
+    poolGive(&schedulers, scheduler);
+}
+
+bool schedulerAddTask(struct Scheduler *scheduler, SchedulerTask task, void *context, uint16_t period) {
+    if (scheduler->numberOfEntries == SCHEDULER_MAX_TASKS) {
+        return false;
+    }
+    struct SchedulerEntry *entry = &scheduler->entries[scheduler->numberOfEntries++];
+    entry->task = task;
+    entry->context = context;
+    entry->period = period;
+    entry->deadline = schedulerTicks();
+    return true;
+}
+
+/**
+ * @brief Find due task with the earliest deadline.
+ * @param[in] scheduler : Pointer to scheduler.
+ * @param[in] now : Current tick.
+ * @return Pointer to found entry, @p NULL if no task is due.
+ */
+static struct SchedulerEntry *earliestDue(struct Scheduler *scheduler, uint16_t now) {
+    struct SchedulerEntry *result = NULL;
+    for (uint8_t i = 0; i < scheduler->numberOfEntries; i++) {
+        struct SchedulerEntry *entry = &scheduler->entries[i];
+        if (!isBefore(now, entry->deadline) && (result == NULL || isBefore(entry->deadline, result->deadline))) {
+            result = entry;
+        }
+    }
+    return result;
+}
+
+void schedulerRun(struct Scheduler *scheduler) {
+    scheduler->running = true;
+    while (scheduler->running) {
+        uint16_t now = schedulerTicks();
+        struct SchedulerEntry *entry = earliestDue(scheduler, now);
+        if (entry == NULL) {
+            continue;
+        }
+
+        // Missed deadlines are dropped, instead of running task several times in a row.
+        entry->deadline += entry->period;
+        if (isBefore(entry->deadline, now)) {
+            entry->deadline = now + entry->period;
+        }
+        entry->task(entry->context);
+    }
+}
+
+void schedulerStop(struct Scheduler *scheduler) {
+    scheduler->running = false;
+}
+
+uint16_t schedulerTicks() {
+    return timersTicks();
+}
@@ -0,0 +1,82 @@
+/**
+ * @file
+ * Cooperative task scheduler interface.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __SCHEDULER_H__
+#define __SCHEDULER_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "../memory/ram_budget.h"
+
+/**
+ * @brief Frequency of scheduler clock, one tick is one millisecond.
+ */
+#define SCHEDULER_TICKS_PER_SECOND 1000
+
+/**
+ * @brief Maximum number of tasks handled by a scheduler.
+ */
+#define SCHEDULER_MAX_TASKS 4
+
+/**
+ * @brief Bytes of @ref Scheduler, mostly its task entries.
+ */
+#define SCHEDULER_RAM_BUDGET ((4 + 8 * SCHEDULER_MAX_TASKS) * RAM_BUDGET_SCALE)
+
+/**
+ * @brief Cooperative scheduler state structure.
+ */
+struct Scheduler;
+
+/**
+ * @brief Task body, must return quickly, as it is never preempted by other tasks.
+ */
+typedef void (*SchedulerTask)(void *context);
+
+/**
+ * @brief Initialize @ref Scheduler and start its clock.
+ * @return Pointer to newly created scheduler, @p NULL if the only one exists already.
+ */
+struct Scheduler *schedulerInit();
+
+/**
+ * @brief Destroy @ref Scheduler and stop its clock.
+ * @param[out] scheduler : Pointer to scheduler, which will be destroyed.
+ */
+void schedulerDestroy(struct Scheduler *scheduler);
+
+/**
+ * @brief Add periodic task.
+ * Task with @p 0 period is run whenever no other task is due.
+ * @param[out] scheduler : Pointer to scheduler.
+ * @param[in] task : Task body.
+ * @param[in] context : Argument passed to @p task.
+ * @param[in] period : Ticks between consecutive deadlines of @p task.
+ * @return @p true if task was added, @p false if there is no room for it.
+ */
+bool schedulerAddTask(struct Scheduler *scheduler, SchedulerTask task, void *context, uint16_t period);
+
+/**
+ * @brief Run due tasks, earliest deadline first, until @ref schedulerStop is called.
+ * @param[out] scheduler : Pointer to scheduler.
+ */
+void schedulerRun(struct Scheduler *scheduler);
+
+/**
+ * @brief Make @ref schedulerRun return after currently running task.
+ * @param[out] scheduler : Pointer to scheduler.
+ */
+void schedulerStop(struct Scheduler *scheduler);
+
+/**
+ * @brief Get scheduler clock.
+ * @return Ticks elapsed since scheduler was initialized, wrapping around.
+ */
+uint16_t schedulerTicks();
+
+#endif /* __SCHEDULER_H__ */
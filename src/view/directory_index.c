@@ -0,0 +1,119 @@
+/**
+ * @file
+ * Directory index implementation.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#include "directory_index.h"
+
+/**
+ * @brief Size of a FAT directory entry, directory offsets are kept in entries.
+ */
+#define DIRECTORY_ENTRY_SIZE 32
+
+void directoryIndexInvalidate(struct DirectoryIndex *index) {
+    index->mountId = 0;
+}
+
+/**
+ * @brief Remember directory offset of the entry read next, if it is a checkpoint.
+ * When all checkpoints are used, every other one is dropped and the stride doubles.
+ * @param[out] index : Pointer to index being built.
+ * @param[in] offset : Directory offset of the entry at @ref DirectoryIndex.count, in entries.
+ */
+static void directoryIndexAdd(struct DirectoryIndex *index, uint16_t offset) {
+    if (index->count & ((1U << index->strideShift) - 1)) { // NOLINT
+        return;
+    }
+    if (index->used == DIRECTORY_INDEX_CHECKPOINTS) {
+        for (uint8_t i = 0; i < DIRECTORY_INDEX_CHECKPOINTS / 2; i++) {
+            index->checkpoints[i] = index->checkpoints[2 * i];
+        }
+        index->used = DIRECTORY_INDEX_CHECKPOINTS / 2;
+        index->strideShift++;
+    }
+    // Count is a multiple of the doubled stride too, all checkpoints were used.
+    index->checkpoints[index->used++] = offset;
+}
+
+/**
+ * @brief Build index by reading the whole directory once.
+ * @param[out] index : Pointer to index.
+ * @param[out] directory : Directory object, opened by the caller, left at the end of directory.
+ */
+static void directoryIndexBuild(struct DirectoryIndex *index, DIR *directory) {
+    FILINFO fileInfo;
+
+    index->count = 0;
+    index->strideShift = 0;
+    index->used = 0;
+    for (;;) {
+        uint16_t offset = (uint16_t) (f_telldir(directory) / DIRECTORY_ENTRY_SIZE);
+        if (f_readdir(directory, &fileInfo) != FR_OK || !fileInfo.fname[0]) {
+            break;
+        }
+        directoryIndexAdd(index, offset);
+        index->count++;
+    }
+    index->mountId = directory->obj.id;
+}
+
+/**
+ * @brief Open directory, building its index if it is not valid.
+ * @param[out] index : Pointer to index of @p path.
+ * @param[in] path : Path of the indexed directory.
+ * @param[out] directory : Directory object to open.
+ * @return @p true on success, @p false if directory can not be opened.
+ */
+static bool directoryIndexOpenValid(struct DirectoryIndex *index, const char *path, DIR *directory) {
+    if (f_opendir(directory, path) != FR_OK) {
+        return false;
+    }
+    // Ids of mounts start from one, so an invalidated index never matches.
+    if (index->mountId != directory->obj.id) {
+        directoryIndexBuild(index, directory);
+    }
+    return true;
+}
+
+bool directoryIndexOpen(struct DirectoryIndex *index, const char *path, DIR *directory, uint16_t position) {
+    if (!directoryIndexOpenValid(index, path, directory)) {
+        return false;
+    }
+    if (position >= index->count) {
+        f_closedir(directory);
+        return false;
+    }
+
+    uint8_t checkpoint = (uint8_t) (position >> index->strideShift);
+    if (f_seekdir(directory, (DWORD) index->checkpoints[checkpoint] * DIRECTORY_ENTRY_SIZE) != FR_OK) {
+        f_closedir(directory);
+        return false;
+    }
+    FILINFO fileInfo;
+    for (uint16_t skipped = (uint16_t) (checkpoint << index->strideShift); skipped < position; skipped++) {
+        f_readdir(directory, &fileInfo);
+    }
+    return true;
+}
+
+bool directoryIndexRead(struct DirectoryIndex *index, const char *path, uint16_t position, FILINFO *fileInfo) {
+    DIR directory;
+    if (!directoryIndexOpen(index, path, &directory, position)) {
+        return false;
+    }
+    bool result = f_readdir(&directory, fileInfo) == FR_OK && fileInfo->fname[0];
+    f_closedir(&directory);
+    return result;
+}
+
+uint16_t directoryIndexCount(struct DirectoryIndex *index, const char *path) {
+    DIR directory;
+    if (!directoryIndexOpenValid(index, path, &directory)) {
+        return 0;
+    }
+    f_closedir(&directory);
+    return index->count;
+}
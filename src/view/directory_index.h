@@ -0,0 +1,70 @@
+/**
+ * @file
+ * Directory index interface, finding listed entries without scanning the directory from its beginning.
+ *
+ * @author Piotr Krzywicki <krzywicki.ptr@gmail.com>
+ * @date 12.06.2018
+ */
+
+#ifndef __DIRECTORY_INDEX_H__
+#define __DIRECTORY_INDEX_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "../lib/fat-fs/ff.h"
+
+/**
+ * @brief Number of remembered directory offsets.
+ * Records of whole entries do not fit in RAM, so only offsets of every stride-th entry are kept.
+ */
+#define DIRECTORY_INDEX_CHECKPOINTS 4
+
+/**
+ * @brief Structure holding offsets of evenly spaced entries of a directory.
+ * Exposed only because it is embedded in @ref View.
+ */
+struct DirectoryIndex {
+    uint16_t mountId; ///< Id of the volume mount, which the index was built on, @p 0 if it is not built.
+    uint16_t count; ///< Number of listed entries.
+    uint8_t strideShift; ///< Log2 of the number of entries between checkpoints.
+    uint8_t used; ///< Number of valid checkpoints.
+    uint16_t checkpoints[DIRECTORY_INDEX_CHECKPOINTS]; ///< Directory offsets of checkpoint entries, in entries.
+};
+
+/**
+ * @brief Forget indexed directory, next lookup builds the index again.
+ * @param[out] index : Pointer to index.
+ */
+void directoryIndexInvalidate(struct DirectoryIndex *index);
+
+/**
+ * @brief Open directory, so that next read returns entry at @p position.
+ * Index is built first, if it was invalidated or the volume was mounted again since it was built.
+ * At most stride minus one entries are skipped by reading, the rest is a single seek.
+ * @param[out] index : Pointer to index of @p path.
+ * @param[in] path : Path of the indexed directory.
+ * @param[out] directory : Directory object to open, it has to be closed by the caller on success.
+ * @param[in] position : Position of the entry, counted from @p 0.
+ * @return @p true on success, @p false if directory can not be opened, or there is no such entry.
+ */
+bool directoryIndexOpen(struct DirectoryIndex *index, const char *path, DIR *directory, uint16_t position);
+
+/**
+ * @brief Read entry at @p position.
+ * @param[out] index : Pointer to index of @p path.
+ * @param[in] path : Path of the indexed directory.
+ * @param[in] position : Position of the entry, counted from @p 0.
+ * @param[out] fileInfo : Read entry.
+ * @return @p true on success, @p false if there is no such entry.
+ */
+bool directoryIndexRead(struct DirectoryIndex *index, const char *path, uint16_t position, FILINFO *fileInfo);
+
+/**
+ * @brief Get number of entries, building the index if needed.
+ * @param[out] index : Pointer to index of @p path.
+ * @param[in] path : Path of the indexed directory.
+ * @return Number of listed entries, @p 0 if directory can not be opened.
+ */
+uint16_t directoryIndexCount(struct DirectoryIndex *index, const char *path);
+
+#endif /* __DIRECTORY_INDEX_H__ */
@@ -7,22 +7,21 @@
  */
 
 #include <stddef.h>
-#include <avr/io.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
 #include "view.h"
 #include "screen_utils.h"
+#include "directory_index.h"
 #include "../lib/fat-fs/ff.h"
+#include "../lib/fat-fs/diskio.h"
+#include "../hal/uart.h"
+#include "../hal/timers.h"
 #include "../player/wav_player.h"
 #include "../player/wav_file.h"
+#include "../memory/pool.h"
 #include <inttypes.h>
 
-/**
- * @brief Maximum length of file/directory path.
- */
-#define MAXIMUM_PATH_LENGTH 32
-
 /**
  * @brief Directory separator symbol, used when displaying and with Fatfs library.
  */
@@ -33,108 +32,469 @@
  */
 #define PARENT_DIRECTORY ".."
 
+/**
+ * @brief Number of text rows on screen.
+ */
+#define VIEW_ROWS (LCD_HEIGHT / LCD_CHAR_HEIGHT)
+
+/**
+ * @brief Number of text columns on screen.
+ */
+#define VIEW_COLUMNS (LCD_WIDTH / LCD_CHAR_WIDTH)
+
+/**
+ * @brief Number of character cells on screen, every render command draws one.
+ */
+#define VIEW_CELLS (VIEW_ROWS * VIEW_COLUMNS)
+
+/**
+ * @brief Estimated cycles of drawing a single character cell.
+ */
+#define VIEW_GLYPH_CYCLES ((uint32_t) LCD_CHAR_WIDTH * LCD_CHAR_HEIGHT * LCD_PIXEL_CYCLES)
+
+/**
+ * @brief Estimated cycles of drawing a whole text row.
+ */
+#define VIEW_ROW_CYCLES (VIEW_COLUMNS * VIEW_GLYPH_CYCLES)
+
+// Glyph is drawn at least once a half, when buffer is full. Samples of the refilled half have to cover it
+// above the near miss margin in the worst case of formats, otherwise refill following it would be late.
+_Static_assert(VIEW_GLYPH_CYCLES / (F_CPU / WAV_PLAYER_OUTPUT_RATE)
+               + (PLAYBACK_BUFFER_MINIMUM_HALF_SAMPLES >> PLAYBACK_BUFFER_NEAR_MISS_SHIFT)
+               <= PLAYBACK_BUFFER_MINIMUM_HALF_SAMPLES, "glyph takes too long to draw while playing");
+
+/**
+ * @brief Screens shown by view.
+ */
+enum ViewScreen {
+    VIEW_SCREEN_LIST, ///< Listing of current directory.
+    VIEW_SCREEN_PLAYING, ///< Selected song being played.
+    VIEW_SCREEN_PAUSED, ///< Paused song, with playback telemetry.
+    VIEW_SCREEN_STOPPED, ///< Last played song, with playback telemetry.
+    VIEW_SCREEN_UNSUPPORTED ///< Selected file, which can not be played.
+};
+
+/**
+ * @brief Lines of screens showing selected song, from top. A line takes a row, but path, which may wrap.
+ */
+enum ViewLine {
+    VIEW_LINE_LABEL,
+    VIEW_LINE_PATH,
+    VIEW_LINE_CHANNELS,
+    VIEW_LINE_SAMPLE_RATE,
+    VIEW_LINE_BITS_PER_SAMPLE,
+    VIEW_LINE_PLAY_NEXT,
+    VIEW_LINE_UNDERRUNS,
+    VIEW_LINE_NEAR_MISSES,
+    VIEW_LINE_MINIMUM_FILL,
+    VIEW_LINE_REFILLS,
+    VIEW_LINE_WORST_REFILL,
+    VIEW_LINE_FRAME_TIME,
+#ifdef SD_STATISTICS
+    VIEW_LINE_SD_BYTES,
+    VIEW_LINE_SD_COMMANDS,
+    VIEW_LINE_SD_SPINS,
+    VIEW_LINE_SD_READ,
+    VIEW_LINE_SD_READY,
+    VIEW_LINE_SD_BLOCK,
+#endif /* SD_STATISTICS */
+
+    VIEW_LINES
+};
+
+/**
+ * @brief Text row composed for drawing, a glyph at a time.
+ */
+struct ViewRow {
+    char text[VIEW_COLUMNS + 1]; ///< Label followed by text, padded with spaces to the whole row.
+    uint8_t labelLength; ///< Number of leading characters drawn on @ref background.
+    uint8_t length; ///< Number of characters of label and text, the rest is drawn on black.
+    uint16_t background; ///< Background of the label.
+};
+
 /**
  * @brief Screen view state holding structure.
+ * Screen is drawn by render commands, one per character cell, run by @ref viewRender from @ref renderCell on.
  */
 struct View {
-    char currentPath[MAXIMUM_PATH_LENGTH]; ///< String containing current path, without current selection.
+    char currentPath[VIEW_MAXIMUM_DIRECTORY_LENGTH]; ///< String containing current path, without current selection.
     FILINFO current; ///< Currently selected file.
     size_t position; ///< Index of current selection.
+    size_t top; ///< Position of the entry shown at the top of the listing.
+    uint16_t frameStart; ///< Scheduler tick, when the screen being drawn was requested.
+    uint16_t frameTime; ///< Ticks between request of the last drawn screen and its last row.
+    uint8_t screen; ///< Shown @ref ViewScreen.
+    uint16_t renderCell; ///< First cell not drawn yet, row by row, @ref VIEW_CELLS if whole screen is drawn.
+    struct DirectoryIndex directoryIndex; ///< Index of @ref currentPath, positions are off by one, parent is not there.
 };
 
+RAM_BUDGET_CHECK(sizeof(struct View), VIEW_RAM_BUDGET);
+
+/**
+ * @brief Storage of the only view, there is a single screen.
+ */
+static struct View viewObjects[1];
+
+/**
+ * @brief Pool of @ref viewObjects.
+ */
+static struct Pool views = POOL_INITIALIZER(viewObjects);
+
 struct View *viewInit(const char *const initialPath) {
-    init();
+    struct View *view = poolTake(&views);
+    if (view == NULL) {
+        return NULL;
+    }
+    lcdInit();
     clearScreen();
 
-    struct View *view = calloc(1, sizeof(struct View));
     view->position = 1;
+    view->top = 0;
+    view->frameTime = 0;
+    view->screen = VIEW_SCREEN_LIST;
+    view->renderCell = VIEW_CELLS;
     strcpy(view->currentPath, initialPath);
+    directoryIndexInvalidate(&view->directoryIndex);
     return view;
 }
 
 void viewDestroy(struct View *view) {
-    free(view);
+    poolGive(&views, view);
 }
 
-void viewPositionUp(struct View *const view) {
-    view->position++;
-    viewAvailableSongs(view);
+/**
+ * @brief Request drawing of rows from @p row down, they are drawn later by @ref viewRender.
+ * @param[out] view : Pointer to view structure.
+ * @param[in] row : First row to draw.
+ */
+static void viewInvalidate(struct View *view, uint8_t row) {
+    if (view->renderCell == VIEW_CELLS) {
+        view->frameStart = timersTicks();
+    }
+    if (row * VIEW_COLUMNS < view->renderCell) {
+        view->renderCell = (uint16_t) (row * VIEW_COLUMNS);
+    }
 }
 
-void viewPositionDown(struct View *const view) {
-    view->position--;
-    viewAvailableSongs(view);
+/**
+ * @brief Compose a text row: label with its background, followed by text, and blank rest of the row.
+ * @param[out] content : Composed row.
+ * @param[in] background : Background of @p label.
+ * @param[in] label : Label, may be empty.
+ * @param[in] text : Text drawn after label, both fit in the row.
+ */
+static void viewSetRow(struct ViewRow *content, uint16_t background, const char *label, const char *text) {
+    size_t labelLength = strlen(label);
+    size_t textLength = strlen(text);
+    memset(content->text, ' ', VIEW_COLUMNS);
+    content->text[VIEW_COLUMNS] = 0;
+    memcpy(content->text, label, labelLength);
+    memcpy(content->text + labelLength, text, textLength);
+    content->labelLength = (uint8_t) labelLength;
+    content->length = (uint8_t) (labelLength + textLength);
+    content->background = background;
 }
 
 /**
- * @brief Show entry on display in proper way.
- * @param[in] view : Pointer to view structure.
- * @param[in] fileInfo : Pointer to entry, which has to be displayed.
- * @param[in] read : Number of already read entries.
- */
-static void viewProcessEntry(struct View *const view, FILINFO *fileInfo, size_t read) {
-    if (read == view->position) {
-        setTextColor(WHITE, RED); // NOLINT
-        view->current = *fileInfo;
-        if (view->current.fattrib & AM_DIR) { // NOLINT
-            setTextColor(WHITE, VIOLET); // NOLINT
+ * @brief Compose a row of text wrapped over several rows.
+ * @param[out] content : Composed row.
+ * @param[in] text : Whole text.
+ * @param[in] segment : Index of the row of @p text to compose.
+ */
+static void viewSetSegment(struct ViewRow *content, const char *text, uint8_t segment) {
+    char line[VIEW_COLUMNS + 1] = {0};
+    strncpy(line, text + segment * VIEW_COLUMNS, VIEW_COLUMNS);
+    viewSetRow(content, BLUE, "", line);
+}
+
+/**
+ * @brief Draw character cells of a composed row, every run of cells sharing background is printed at once.
+ * Characters are drawn with their background, so the row is not cleared first.
+ * @param[in] row : Row to draw at.
+ * @param[in] content : Composed row.
+ * @param[in] column : First cell to draw.
+ * @param[in] end : One past the last cell to draw, up to @ref VIEW_COLUMNS.
+ */
+static void viewDrawCells(uint8_t row, const struct ViewRow *content, uint8_t column, uint8_t end) {
+    lcdSetCursor((int16_t) (column * LCD_CHAR_WIDTH), (int16_t) (row * LCD_CHAR_HEIGHT));
+    while (column < end) {
+        uint16_t background = BLACK;
+        uint8_t runEnd = end;
+        if (column < content->labelLength) {
+            background = content->background;
+            runEnd = content->labelLength < end ? content->labelLength : end;
         }
+        else if (column < content->length) {
+            background = BLUE;
+            runEnd = content->length < end ? content->length : end;
+        }
+        char run[VIEW_COLUMNS + 1] = {0};
+        memcpy(run, content->text + column, runEnd - column);
+        lcdSetTextColor(WHITE, background);
+        lcdPrint(run);
+        column = runEnd;
     }
+}
+
+/**
+ * @brief Get position of the first listed entry, parent directory is listed everywhere but in root.
+ * @param[in] view : Pointer to view structure.
+ * @return @p 0 if parent directory is listed, @p 1 otherwise.
+ */
+static size_t viewFirstPosition(const struct View *view) {
+    return strcmp(view->currentPath, ROOT_PATH) == 0 ? 1 : 0;
+}
+
+/**
+ * @brief Get number of text rows of current directory header, above the listing.
+ * @param[in] view : Pointer to view structure.
+ * @return Number of rows.
+ */
+static uint8_t viewHeaderRows(const struct View *view) {
+    return (uint8_t) ((strlen(view->currentPath) + VIEW_COLUMNS - 1) / VIEW_COLUMNS);
+}
 
-    print(view->currentPath);
-    if (strcmp(view->currentPath, ROOT_PATH) != 0) {
-        print(ROOT_PATH);
+/**
+ * @brief Get number of listed entries shown at once, the page.
+ * @param[in] view : Pointer to view structure.
+ * @return Number of rows below the header.
+ */
+static uint8_t viewPageRows(const struct View *view) {
+    return (uint8_t) (VIEW_ROWS - viewHeaderRows(view));
+}
+
+/**
+ * @brief Get number of rows the listing is scrolled by in hardware, rows of entries rotate by it.
+ * Pages start at multiples of @ref viewPageRows from the first entry, where listing is not scrolled.
+ * @param[in] view : Pointer to view structure.
+ * @return Number of rows.
+ */
+static uint8_t viewScrolledRows(const struct View *view) {
+    return (uint8_t) ((view->top - viewFirstPosition(view)) % viewPageRows(view));
+}
+
+/**
+ * @brief Get text row, which a listed entry is drawn at.
+ * @param[in] view : Pointer to view structure.
+ * @param[in] position : Position of the entry.
+ * @return Row of the entry, @ref VIEW_ROWS if it is not on the page.
+ */
+static uint8_t viewRow(const struct View *view, size_t position) {
+    uint8_t pageRows = viewPageRows(view);
+    if (position < view->top || position - view->top >= pageRows) {
+        return VIEW_ROWS;
     }
+    return (uint8_t) (viewHeaderRows(view) + (position - view->top + viewScrolledRows(view)) % pageRows);
+}
 
-    print(fileInfo->fname);
-    write('\n');
-    restoreColours();
+/**
+ * @brief Get position of the entry drawn at a row of the listing, inverse of @ref viewRow.
+ * @param[in] view : Pointer to view structure.
+ * @param[in] row : Row below the header.
+ * @return Position of the entry, it may be past the last one.
+ */
+static size_t viewRowPosition(const struct View *view, uint8_t row) {
+    uint8_t pageRows = viewPageRows(view);
+    return view->top + (row - viewHeaderRows(view) + pageRows - viewScrolledRows(view)) % pageRows;
+}
+
+/**
+ * @brief Compose row of a single listed entry, highlighted if it is selected.
+ * @param[in] view : Pointer to view structure.
+ * @param[out] content : Composed row.
+ * @param[in] position : Position of the entry.
+ * @param[in] fileInfo : The entry.
+ */
+static void viewSetEntry(const struct View *view, struct ViewRow *content, size_t position, const FILINFO *fileInfo) {
+    uint16_t background = BLUE;
+    if (position == view->position) {
+        background = position != 0 && fileInfo->fattrib & AM_DIR ? VIOLET : RED; // NOLINT
+    }
+    viewSetRow(content, background, fileInfo->fname, "");
+}
+
+/**
+ * @brief Find entry of current directory by its position, without drawing anything.
+ * @param[in] view : Pointer to view structure.
+ * @param[in] position : Position of the entry, @p 0 is parent directory.
+ * @param[out] fileInfo : Found entry.
+ * @return @p true if entry was found, @p false if there is no such position.
+ */
+static bool viewFindEntry(struct View *view, size_t position, FILINFO *fileInfo) {
+    if (position < viewFirstPosition(view)) {
+        return false;
+    }
+    if (position == 0) {
+        strcpy(fileInfo->fname, PARENT_DIRECTORY);
+        fileInfo->fattrib = AM_DIR;
+        return true;
+    }
+    return directoryIndexRead(&view->directoryIndex, view->currentPath, (uint16_t) (position - 1), fileInfo);
 }
 
 /**
- * @brief Show parent directory on display if necessary.
+ * @brief Compose a row of the listing, header or an entry.
+ * Consecutive entries are read from @p directory, left open between calls, reopening it through index otherwise.
  * @param[in] view : Pointer to view structure.
+ * @param[in] row : Row to compose.
+ * @param[out] content : Composed row.
+ * @param[out] directory : Directory object, open if @p next is not @p 0.
+ * @param[in,out] next : Position of the entry @p directory is at, @p 0 if it is closed.
+ */
+static void viewSetListRow(struct View *view, uint8_t row, struct ViewRow *content, DIR *directory, size_t *next) {
+    if (row < viewHeaderRows(view)) {
+        viewSetSegment(content, view->currentPath, row);
+        return;
+    }
+
+    FILINFO fileInfo;
+    size_t position = viewRowPosition(view, row);
+    bool found;
+    if (position == 0) {
+        found = viewFindEntry(view, 0, &fileInfo);
+    }
+    else {
+        if (*next != position) {
+            if (*next != 0) {
+                f_closedir(directory);
+            }
+            bool opened = directoryIndexOpen(&view->directoryIndex, view->currentPath, directory,
+                                             (uint16_t) (position - 1));
+            *next = opened ? position : 0;
+        }
+        found = *next != 0 && f_readdir(directory, &fileInfo) == FR_OK && fileInfo.fname[0];
+        if (found) {
+            (*next)++;
+        }
+    }
+
+    if (found) {
+        viewSetEntry(view, content, position, &fileInfo);
+    }
+    else {
+        viewSetRow(content, BLUE, "", "");
+    }
+}
+
+/**
+ * @brief Scroll the listing by a single entry in hardware, without drawing anything.
+ * Row of the entry leaving the page is shown at the other end of it, for the entry coming in.
+ * @param[out] view : Pointer to view structure.
+ * @param[in] down : Scroll to the following entries if @p true, to the preceding ones otherwise.
+ */
+static void viewScroll(struct View *view, bool down) {
+    if (down) {
+        view->top++;
+    }
+    else {
+        view->top--;
+    }
+    lcdScrollTo((uint8_t) (viewScrolledRows(view) * LCD_CHAR_HEIGHT));
+}
+
+/**
+ * @brief Move selection, if there is an entry at @p position.
+ * Listing on screen is updated by repainting the two affected rows, scrolling it by one row if selection leaves it.
+ * Otherwise it is shown whole.
+ * @param[out] view : Pointer to view structure.
+ * @param[in] position : Position of the new selection.
  */
-static void prependParentDirectory(const struct View *view) {
-    if (strcmp(view->currentPath, ROOT_PATH) != 0) {
-        if (view->position == 0) {
-            setTextColor(WHITE, RED); // NOLINT
+static void viewMoveTo(struct View *const view, size_t position) {
+    FILINFO fileInfo;
+    if (!viewFindEntry(view, position, &fileInfo)) {
+        if (view->screen != VIEW_SCREEN_LIST) {
+            viewAvailableSongs(view);
         }
-        print(PARENT_DIRECTORY);
-        write('\n');
-        restoreColours();
+        return;
+    }
+
+    bool adjacent = position + 1 == view->position || position == view->position + 1;
+    if (view->screen != VIEW_SCREEN_LIST || (viewRow(view, position) == VIEW_ROWS && !adjacent)) {
+        view->position = position;
+        viewAvailableSongs(view);
+        return;
+    }
+    if (viewRow(view, position) == VIEW_ROWS) {
+        viewScroll(view, position > view->position);
+    }
+    size_t previous = view->position;
+    FILINFO previousInfo = view->current;
+    view->position = position;
+    view->current = fileInfo;
+
+    uint8_t previousRow = viewRow(view, previous);
+    uint8_t row = viewRow(view, position);
+    // Nothing waits to be drawn, so the two rows can be drawn at once instead of everything below them.
+    if (view->renderCell == VIEW_CELLS && wavPlayerDrawingBudget(0) >= 2 * VIEW_ROW_CYCLES) {
+        struct ViewRow content;
+        viewSetEntry(view, &content, previous, &previousInfo);
+        viewDrawCells(previousRow, &content, 0, VIEW_COLUMNS);
+        viewSetEntry(view, &content, position, &fileInfo);
+        viewDrawCells(row, &content, 0, VIEW_COLUMNS);
+    }
+    else {
+        viewInvalidate(view, previousRow < row ? previousRow : row);
+    }
+}
+
+void viewPositionUp(struct View *const view) {
+    viewMoveTo(view, view->position + 1);
+}
+
+void viewPositionDown(struct View *const view) {
+    if (view->position > 0) {
+        viewMoveTo(view, view->position - 1);
+    }
+    else if (view->screen != VIEW_SCREEN_LIST) {
+        viewAvailableSongs(view);
     }
 }
 
 void viewAvailableSongs(struct View *view) {
-    DIR directory;
     FILINFO fileInfo;
+    uint8_t pageRows = viewPageRows(view);
 
-    clearScreen();
+    // Listing is kept where it was if selection is still there, otherwise it starts the page holding selection.
+    size_t first = viewFirstPosition(view);
+    size_t position = view->position < first ? first : view->position;
+    if (view->top < first || position < view->top || position - view->top >= pageRows) {
+        view->top = position - (position - first) % pageRows;
+    }
+    if (viewFindEntry(view, view->position, &fileInfo)) {
+        view->current = fileInfo;
+    }
 
-    prependParentDirectory(view);
+    view->screen = VIEW_SCREEN_LIST;
+    lcdScrollArea((uint8_t) (viewHeaderRows(view) * LCD_CHAR_HEIGHT), (uint8_t) (pageRows * LCD_CHAR_HEIGHT));
+    lcdScrollTo((uint8_t) (viewScrolledRows(view) * LCD_CHAR_HEIGHT));
+    viewInvalidate(view, 0);
+}
 
-    size_t read = 1;
-    FRESULT openResult = f_opendir(&directory, view->currentPath);
-    if (openResult == FR_OK) {
-        while (f_readdir(&directory, &fileInfo) == FR_OK && (&fileInfo)->fname[0]) {
-            viewProcessEntry(view, &fileInfo, read);
-            read++;
-        }
-        f_closedir(&directory);
+/**
+ * @brief Get path of a file in current directory.
+ * @param[in] view : Pointer to view structure.
+ * @param[in] fileInfo : File in current directory.
+ * @param[out] path : Buffer of @ref VIEW_PATH_SIZE bytes.
+ */
+static void viewGetPath(const struct View *view, const FILINFO *fileInfo, char *path) {
+    strcpy(path, view->currentPath);
+    if (strlen(path) > strlen(ROOT_PATH)) {
+        strcat(path, DIRECTORY_SEPARATOR);
     }
+    strcat(path, fileInfo->fname);
 }
 
 /**
- * @brief Change directory based on a selected one.
+ * @brief Change directory based on a selected one, directories with too long paths are not entered.
  * @param[in] view : Pointer to view structure.
  */
 static void viewUpdateCurrentPath(struct View *view) {
     if (view->position != 0) {
-        if (strlen(view->currentPath) > strlen(ROOT_PATH)) {
-            strcat(view->currentPath, DIRECTORY_SEPARATOR);
+        char path[VIEW_PATH_SIZE];
+        viewGetPath(view, &view->current, path);
+        if (strlen(path) < sizeof(view->currentPath)) {
+            strcpy(view->currentPath, path);
         }
-        strcat(view->currentPath, view->current.fname);
     }
     else {
         *strrchr(view->currentPath, DIRECTORY_SEPARATOR[0]) = 0;
@@ -146,7 +506,9 @@ static void viewUpdateCurrentPath(struct View *view) {
 
 void viewEnterDirectory(struct View *const view) {
     viewUpdateCurrentPath(view);
+    directoryIndexInvalidate(&view->directoryIndex);
     view->position = 1;
+    view->top = 0;
     viewAvailableSongs(view);
 }
 
@@ -154,46 +516,323 @@ bool viewIsCurrentDir(struct View *const view) {
     return !view->position || view->current.fattrib & AM_DIR; // NOLINT
 }
 
-char *viewGetCurrentPath(struct View *const view) {
-    char *result = malloc(strlen(view->current.fname) + strlen(view->currentPath) + 1);
-    strcpy(result, view->currentPath);
-    if (strlen(result) > strlen(ROOT_PATH)) {
-        strcat(result, DIRECTORY_SEPARATOR);
+void viewGetCurrentPath(struct View *const view, char *path) {
+    viewGetPath(view, &view->current, path);
+}
+
+bool viewGetNextSong(struct View *const view, struct ViewSelection *next) {
+    DIR directory;
+    bool result = false;
+
+    // Index position of the entry after current one equals current position, which counts parent directory in.
+    if (!directoryIndexOpen(&view->directoryIndex, view->currentPath, &directory, (uint16_t) view->position)) {
+        return false;
     }
-    strcat(result, view->current.fname);
+    size_t read = view->position + 1;
+    while (f_readdir(&directory, &next->entry) == FR_OK && next->entry.fname[0]) {
+        if (!(next->entry.fattrib & AM_DIR)) { // NOLINT
+            next->position = read;
+            result = true;
+            break;
+        }
+        read++;
+    }
+    f_closedir(&directory);
     return result;
 }
 
+void viewGetSelectionPath(struct View *const view, const struct ViewSelection *selection, char *path) {
+    viewGetPath(view, &selection->entry, path);
+}
+
+void viewSelect(struct View *const view, const struct ViewSelection *selection) {
+    view->current = selection->entry;
+    view->position = selection->position;
+}
+
+#ifdef SD_STATISTICS
 /**
- * @brief Display current wav file with label.
- * @param[in] view : Pointer to a view structure.
- * @param[in] label : Label printed before showing current wav file.
+ * @brief Format latency histogram as a digit per bucket scaled to the fullest one.
+ * Empty buckets are shown as dots, so that rare slow ones stand out.
+ * @param[out] line : Buffer of @ref DSTATS_BUCKETS + 1 bytes.
+ * @param[in] histogram : Histogram of @ref DSTATS_BUCKETS buckets.
  */
-static void displayCurrent(struct View *const view, const char *const label) {
-    clearScreen();
-    setTextColor(WHITE, RED);
-    print(label);
-    restoreColours();
+static void formatHistogram(char *line, const BYTE *histogram) {
+    uint16_t fullest = 1;
+    for (uint8_t i = 0; i < DSTATS_BUCKETS; i++) {
+        if (histogram[i] > fullest) {
+            fullest = histogram[i];
+        }
+    }
+    for (uint8_t i = 0; i < DSTATS_BUCKETS; i++) {
+        line[i] = histogram[i] ? (char) ('0' + (histogram[i] * 9U + fullest - 1) / fullest) : '.';
+    }
+    line[DSTATS_BUCKETS] = 0;
+}
+
+#ifdef UART_AVAILABLE
+/**
+ * @brief Send labelled whole histogram over UART, as a line of bucket counters.
+ * @param[in] label : Label sent before histogram.
+ * @param[in] histogram : Histogram of @ref DSTATS_BUCKETS buckets.
+ */
+static void dumpHistogram(const char *const label, const BYTE *histogram) {
+    char buffer[4];
+    uartPrint(label);
+    for (uint8_t i = 0; i < DSTATS_BUCKETS; i++) {
+        uartWrite(' ');
+        uartPrint(utoa(histogram[i], buffer, 10));
+    }
+    uartPrint("\r\n");
+}
+
+/**
+ * @brief Send disk I/O statistics over UART.
+ * @param[in] stats : Statistics of the disk layer.
+ */
+static void dumpDiskStats(const DSTATS *stats) {
+    char buffer[11];
+    uartPrint("sd bytes ");
+    uartPrint(ultoa(stats->bytes, buffer, 10));
+    uartPrint(" commands ");
+    uartPrint(utoa(stats->commands, buffer, 10));
+    uartPrint(" spins ");
+    uartPrint(ultoa(stats->spins, buffer, 10));
+    uartPrint("\r\n");
+    dumpHistogram("sd read", stats->read);
+    dumpHistogram("sd ready", stats->ready);
+    dumpHistogram("sd block", stats->block);
+}
+#endif /* UART_AVAILABLE */
+
+#endif /* SD_STATISTICS */
 
-    char *current = viewGetCurrentPath(view);
-    print(current);
-    write('\n');
-    free(current);
+/**
+ * @brief Check if screen shows playback telemetry, it takes too long to draw it while playing.
+ * @param[in] screen : Examined @ref ViewScreen.
+ * @return @p true if it does, @p false otherwise.
+ */
+static bool viewScreenHasStats(uint8_t screen) {
+    return screen == VIEW_SCREEN_PAUSED || screen == VIEW_SCREEN_STOPPED;
+}
 
-    struct WavFile *currentlyPlayingFile = wavPlayerGetWavFile(wavPlayerGetCurrentlyPlaying());
-    if (currentlyPlayingFile != NULL) {
-        wavFilePrint(currentlyPlayingFile);
+/**
+ * @brief Get number of rows of a line of screen showing selected song.
+ * @param[in] view : Pointer to view structure.
+ * @param[in] line : Examined @ref ViewLine.
+ * @param[in] path : Path of selected song.
+ * @return Number of rows, @p 0 if line is not shown.
+ */
+static uint8_t viewLineRows(const struct View *view, uint8_t line, const char *path) {
+    if (line == VIEW_LINE_PATH) {
+        return (uint8_t) ((strlen(path) + VIEW_COLUMNS - 1) / VIEW_COLUMNS);
+    }
+    if (line >= VIEW_LINE_CHANNELS && line <= VIEW_LINE_BITS_PER_SAMPLE) {
+        return wavPlayerGetCurrentlyPlaying() != NULL ? 1 : 0;
     }
+    if (line >= VIEW_LINE_UNDERRUNS) {
+        return viewScreenHasStats(view->screen) ? 1 : 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Get label of screen showing selected song.
+ * @param[in] screen : Shown @ref ViewScreen.
+ * @return Label, printed before path of the song.
+ */
+static const char *viewScreenLabel(uint8_t screen) {
+    switch (screen) {
+        case VIEW_SCREEN_PLAYING:
+            return "Playing:";
+        case VIEW_SCREEN_PAUSED:
+            return "Paused:";
+        case VIEW_SCREEN_STOPPED:
+            return "Stopped:";
+        default:
+            return "Unsupported:";
+    }
+}
+
+/**
+ * @brief Compose a row of screen showing selected song, with its properties and playback telemetry.
+ * @param[in] view : Pointer to view structure.
+ * @param[in] row : Row to compose.
+ * @param[out] content : Composed row.
+ */
+static void viewSetCurrentRow(struct View *view, uint8_t row, struct ViewRow *content) {
+    char path[VIEW_PATH_SIZE];
+    viewGetCurrentPath(view, path);
+
+    uint8_t line = 0;
+    uint8_t lineRow = 0;
+    for (; line < VIEW_LINES; line++) {
+        uint8_t rows = viewLineRows(view, line, path);
+        if (row < lineRow + rows) {
+            break;
+        }
+        lineRow = (uint8_t) (lineRow + rows);
+    }
+
+    char text[VIEW_COLUMNS + 1] = {0};
+    const char *label = "";
+    uint32_t number = 0;
+    const struct PlaybackStats *stats = wavPlayerGetStats();
+    struct WavPlayer *currentlyPlaying = wavPlayerGetCurrentlyPlaying();
+    struct WavFile *wavFile = currentlyPlaying != NULL ? wavPlayerGetWavFile(currentlyPlaying) : NULL;
+#ifdef SD_STATISTICS
+    const DSTATS *diskStats = disk_stats(0);
+#endif /* SD_STATISTICS */
+    switch (line) {
+        case VIEW_LINE_LABEL:
+            viewSetRow(content, RED, viewScreenLabel(view->screen), "");
+            return;
+        case VIEW_LINE_PATH:
+            viewSetSegment(content, path, (uint8_t) (row - lineRow));
+            return;
+        case VIEW_LINE_PLAY_NEXT:
+            viewSetRow(content, RED, "Play next: ", wavPlayerIsPlayNext() ? "on" : "off");
+            return;
+        case VIEW_LINE_CHANNELS:
+            label = "Channels: ";
+            number = wavFileNumberOfChannels(wavFile);
+            break;
+        case VIEW_LINE_SAMPLE_RATE:
+            label = "Sample rate: ";
+            number = wavFileSampleRate(wavFile);
+            break;
+        case VIEW_LINE_BITS_PER_SAMPLE:
+            label = "Bits per sample: ";
+            number = wavFileBitsPerSample(wavFile);
+            break;
+        case VIEW_LINE_UNDERRUNS:
+            label = "Underruns: ";
+            number = stats->underruns;
+            break;
+        case VIEW_LINE_NEAR_MISSES:
+            label = "Near misses: ";
+            number = stats->nearMisses;
+            break;
+        case VIEW_LINE_MINIMUM_FILL:
+            label = "Minimum fill: ";
+            number = stats->refills ? stats->minimumFill : 0;
+            break;
+        case VIEW_LINE_REFILLS:
+            label = "Refills: ";
+            number = stats->refills;
+            break;
+        case VIEW_LINE_WORST_REFILL:
+            label = "Worst refill: ";
+            number = stats->worstRefillDuration;
+            break;
+        case VIEW_LINE_FRAME_TIME:
+            label = "Frame time: ";
+            number = view->frameTime;
+            break;
+#ifdef SD_STATISTICS
+        case VIEW_LINE_SD_BYTES:
+            label = "SD bytes: ";
+            number = diskStats->bytes;
+            break;
+        case VIEW_LINE_SD_COMMANDS:
+            label = "SD commands: ";
+            number = diskStats->commands;
+            break;
+        case VIEW_LINE_SD_SPINS:
+            label = "SD spins: ";
+            number = diskStats->spins;
+            break;
+        case VIEW_LINE_SD_READ:
+            formatHistogram(text, diskStats->read);
+            viewSetRow(content, RED, "Read  ", text);
+            return;
+        case VIEW_LINE_SD_READY:
+            formatHistogram(text, diskStats->ready);
+            viewSetRow(content, RED, "Ready ", text);
+            return;
+        case VIEW_LINE_SD_BLOCK:
+            formatHistogram(text, diskStats->block);
+            viewSetRow(content, RED, "Block ", text);
+            return;
+#endif /* SD_STATISTICS */
+        default:
+            viewSetRow(content, BLUE, "", "");
+            return;
+    }
+    ultoa(number, text, 10);
+    viewSetRow(content, RED, label, text);
+}
+
+bool viewRender(struct View *view) {
+    DIR directory;
+    size_t next = 0;
+    struct ViewRow content;
+    uint8_t composedRow = VIEW_ROWS;
+    bool drawing = view->renderCell < VIEW_CELLS;
+    // Buffer only drains while drawing, so its budget is taken once.
+    uint32_t budget = wavPlayerDrawingBudget(VIEW_GLYPH_CYCLES);
+
+    while (view->renderCell < VIEW_CELLS && budget >= VIEW_GLYPH_CYCLES) {
+        uint8_t row = (uint8_t) (view->renderCell / VIEW_COLUMNS);
+        uint8_t column = (uint8_t) (view->renderCell % VIEW_COLUMNS);
+        if (row != composedRow) {
+            composedRow = row;
+            if (view->screen == VIEW_SCREEN_LIST) {
+                viewSetListRow(view, row, &content, &directory, &next);
+            }
+            else {
+                viewSetCurrentRow(view, row, &content);
+            }
+        }
+        // Commands left in the row, which fit in the budget, are drawn together.
+        uint32_t cells = budget / VIEW_GLYPH_CYCLES;
+        uint8_t end = cells < (uint8_t) (VIEW_COLUMNS - column) ? (uint8_t) (column + cells) : VIEW_COLUMNS;
+        viewDrawCells(row, &content, column, end);
+        view->renderCell = (uint16_t) (view->renderCell + end - column);
+        budget -= (end - column) * VIEW_GLYPH_CYCLES;
+    }
+    if (next != 0) {
+        f_closedir(&directory);
+    }
+
+    if (drawing && view->renderCell == VIEW_CELLS) {
+        view->frameTime = (uint16_t) (timersTicks() - view->frameStart);
+    }
+    return view->renderCell < VIEW_CELLS;
+}
+
+uint16_t viewFrameTime(struct View *view) {
+    return view->frameTime;
+}
+
+/**
+ * @brief Show selected song, its rows are drawn later by @ref viewRender.
+ * @param[out] view : Pointer to a view structure.
+ * @param[in] screen : @ref ViewScreen to show.
+ */
+static void viewShowCurrent(struct View *const view, uint8_t screen) {
+    view->screen = screen;
+    lcdScrollTo(0);
+    viewInvalidate(view, 0);
+#if defined(SD_STATISTICS) && defined(UART_AVAILABLE)
+    if (viewScreenHasStats(screen)) {
+        dumpDiskStats(disk_stats(0));
+    }
+#endif
 }
 
 void viewPlaying(struct View *view) {
-    displayCurrent(view, "Playing:\n");
+    viewShowCurrent(view, VIEW_SCREEN_PLAYING);
 }
 
 void viewPaused(struct View *view) {
-    displayCurrent(view, "Paused:\n");
+    viewShowCurrent(view, VIEW_SCREEN_PAUSED);
 }
 
 void viewStopped(struct View *view) {
-    displayCurrent(view, "Stopped:\n");
+    viewShowCurrent(view, VIEW_SCREEN_STOPPED);
+}
+
+void viewUnsupported(struct View *view) {
+    viewShowCurrent(view, VIEW_SCREEN_UNSUPPORTED);
 }
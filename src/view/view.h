@@ -10,21 +10,48 @@
 #define __VIEW_H__
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../lib/fat-fs/ff.h"
+#include "../memory/ram_budget.h"
 
 /**
  * @brief Filesystem root path symbol.
  */
 #define ROOT_PATH "/"
 
+/**
+ * @brief Maximum length of directory path, with terminator.
+ */
+#define VIEW_MAXIMUM_DIRECTORY_LENGTH 32
+
+/**
+ * @brief Size of a buffer for selected file path: directory path, separator and file name.
+ */
+#define VIEW_PATH_SIZE (VIEW_MAXIMUM_DIRECTORY_LENGTH + sizeof(((FILINFO *) 0)->fname))
+
+/**
+ * @brief Bytes of @ref View, mostly its path and selected entry.
+ */
+#define VIEW_RAM_BUDGET (79 * RAM_BUDGET_SCALE)
+
 /**
  * @brief Screen view state holding structure.
  */
 struct View;
 
+/**
+ * @brief Selectable directory entry, remembered to be selected later without listing the directory again.
+ */
+struct ViewSelection {
+    FILINFO entry; ///< Selected file.
+    size_t position; ///< Index of the selection.
+};
+
 /**
  * @brief Initialize view structure.
  * @param[in] initialPath : Songs listing directory path.
- * @return Pointer to new @ref View.
+ * @return Pointer to new @ref View, @p NULL if the only one exists already.
  */
 struct View *viewInit(const char *initialPath);
 
@@ -70,12 +97,41 @@ void viewPaused(struct View *view);
  */
 void viewStopped(struct View *view);
 
+/**
+ * @brief Switch to view informing, that selected file can not be played.
+ * @param[out] view : Pointer to a view structure.
+ */
+void viewUnsupported(struct View *view);
+
 /**
  * @brief Get selected file path.
  * @param[in] view : Pointer to a view structure.
- * @return Created path string, must be freed.
+ * @param[out] path : Buffer of @ref VIEW_PATH_SIZE bytes.
+ */
+void viewGetCurrentPath(struct View *view, char *path);
+
+/**
+ * @brief Find the first song after selected file in current directory, without changing the selection.
+ * @param[in] view : Pointer to a view structure.
+ * @param[out] next : Found song, to be passed to @ref viewSelect.
+ * @return @p true if a song was found, @p false if there is no song after selection.
+ */
+bool viewGetNextSong(struct View *view, struct ViewSelection *next);
+
+/**
+ * @brief Get path of a song found by @ref viewGetNextSong.
+ * @param[in] view : Pointer to a view structure.
+ * @param[in] selection : Found song.
+ * @param[out] path : Buffer of @ref VIEW_PATH_SIZE bytes.
+ */
+void viewGetSelectionPath(struct View *view, const struct ViewSelection *selection, char *path);
+
+/**
+ * @brief Select entry found earlier, screen is not updated.
+ * @param[out] view : Pointer to a view structure.
+ * @param[in] selection : Entry to select.
  */
-char *viewGetCurrentPath(struct View *view);
+void viewSelect(struct View *view, const struct ViewSelection *selection);
 
 /**
  * @brief Check if selected file is a directory.
@@ -90,4 +146,19 @@ bool viewIsCurrentDir(struct View *view);
  */
 void viewEnterDirectory(struct View *view);
 
+/**
+ * @brief Draw character cells of requested screen, as long as playback buffer holds enough samples to draw the next.
+ * Screens are only requested by the other functions, drawing them is left to this one.
+ * @param[out] view : Pointer to a view structure.
+ * @return @p true if some cells are still not drawn, @p false if the whole screen is.
+ */
+bool viewRender(struct View *view);
+
+/**
+ * @brief Get time of drawing the last screen.
+ * @param[in] view : Pointer to a view structure.
+ * @return Scheduler ticks between request of the screen and drawing its last cell.
+ */
+uint16_t viewFrameTime(struct View *view);
+
 #endif /* __VIEW_H__ */